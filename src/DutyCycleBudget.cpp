@@ -0,0 +1,85 @@
+/* Copyright 2013-2019 Homegear GmbH
+ *
+ * Homegear is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Homegear is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Homegear.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "DutyCycleBudget.h"
+
+namespace MyFamily
+{
+
+DutyCycleBudget::DutyCycleBudget(int64_t budget) : _budget(budget)
+{
+}
+
+void DutyCycleBudget::add(int64_t airtime, int64_t time)
+{
+	int64_t minute = time / _bucketLength;
+	int64_t index = minute % _bucketCount;
+	if(_bucketMinutes[index] != minute)
+	{
+		_bucketMinutes[index] = minute;
+		_buckets[index] = 0;
+	}
+	_buckets[index] += airtime;
+}
+
+int64_t DutyCycleBudget::getUsed(int64_t time)
+{
+	int64_t minute = time / _bucketLength;
+	int64_t used = 0;
+	for(int64_t i = 0; i < _bucketCount; i++)
+	{
+		if(_bucketMinutes[i] > minute - _bucketCount) used += _buckets[i];
+	}
+	return used;
+}
+
+int64_t DutyCycleBudget::getAvailableTime(int64_t airtime, int64_t limit, int64_t time)
+{
+	int64_t used = getUsed(time);
+	if(used + airtime <= limit || used == 0) return time;
+
+	//Walk through the buckets from oldest to newest until enough airtime has expired.
+	int64_t minute = time / _bucketLength;
+	for(int64_t bucketMinute = minute - _bucketCount + 1; bucketMinute <= minute; bucketMinute++)
+	{
+		int64_t index = bucketMinute % _bucketCount;
+		if(_bucketMinutes[index] != bucketMinute) continue;
+		used -= _buckets[index];
+		if(used + airtime <= limit) return (bucketMinute + _bucketCount) * _bucketLength;
+	}
+	return (minute + _bucketCount) * _bucketLength; //Airtime larger than limit
+}
+
+void DutyCycleBudget::exhaust(int64_t time)
+{
+	int64_t used = getUsed(time);
+	if(used < _budget) add(_budget - used, time);
+}
+
+}
@@ -0,0 +1,87 @@
+/* Copyright 2013-2019 Homegear GmbH
+ *
+ * Homegear is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Homegear is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Homegear.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef DUTYCYCLEBUDGET_H_
+#define DUTYCYCLEBUDGET_H_
+
+#include <cstdint>
+
+#include <array>
+
+namespace MyFamily
+{
+
+/**
+ * Keeps track of the airtime used by an interface during the last hour to predict when the 1 % duty cycle limit of the CUL
+ * firmware is reached. Airtime is summed up per minute in a ring of 60 buckets, so the window slides in steps of one minute.
+ * The class is not thread safe.
+ */
+class DutyCycleBudget
+{
+public:
+	/**
+	 * @param budget The airtime allowed per hour in milliseconds. The default is 1 %.
+	 */
+	DutyCycleBudget(int64_t budget = 36000);
+	virtual ~DutyCycleBudget() = default;
+
+	int64_t getBudget() { return _budget; }
+
+	/**
+	 * Adds airtime used at the given time (in milliseconds since epoch).
+	 */
+	void add(int64_t airtime, int64_t time);
+
+	/**
+	 * Returns the airtime used during the last hour in milliseconds.
+	 */
+	int64_t getUsed(int64_t time);
+
+	/**
+	 * Returns the time (in milliseconds since epoch) when "airtime" milliseconds can be used without exceeding "limit"
+	 * milliseconds within one hour. Returns "time" when the airtime is available immediately.
+	 */
+	int64_t getAvailableTime(int64_t airtime, int64_t limit, int64_t time);
+
+	/**
+	 * Marks the whole budget as used. Called when the device reports that the limit was reached.
+	 */
+	void exhaust(int64_t time);
+protected:
+	static const int64_t _bucketCount = 60;
+	static const int64_t _bucketLength = 60000;
+
+	int64_t _budget = 0;
+	std::array<int64_t, _bucketCount> _buckets{};
+	std::array<int64_t, _bucketCount> _bucketMinutes{}; //The minute (time / _bucketLength) a bucket belongs to
+};
+
+}
+
+#endif
@@ -0,0 +1,87 @@
+/* Copyright 2013-2019 Homegear GmbH
+ *
+ * Homegear is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Homegear is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Homegear.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "EventBatcher.h"
+
+namespace MyFamily
+{
+
+void EventBatcher::add(uint64_t peerId, int32_t channel, const std::string& valueKey, const BaseLib::PVariable& value)
+{
+	std::lock_guard<std::mutex> eventsGuard(_eventsMutex);
+	_statistics.updates++;
+	auto eventIndexIterator = _eventIndex.find(std::make_pair(peerId, channel));
+	if(eventIndexIterator == _eventIndex.end())
+	{
+		Event event;
+		event.peerId = peerId;
+		event.channel = channel;
+		event.valueKeys = std::make_shared<std::vector<std::string>>();
+		event.values = std::make_shared<std::vector<BaseLib::PVariable>>();
+		event.valueKeys->push_back(valueKey);
+		event.values->push_back(value);
+		_eventIndex.emplace(std::make_pair(peerId, channel), _events.size());
+		_events.push_back(std::move(event));
+		return;
+	}
+
+	Event& event = _events.at(eventIndexIterator->second);
+	for(size_t i = 0; i < event.valueKeys->size(); i++)
+	{
+		if(event.valueKeys->at(i) == valueKey)
+		{
+			event.values->at(i) = value;
+			_statistics.coalesced++;
+			return;
+		}
+	}
+	event.valueKeys->push_back(valueKey);
+	event.values->push_back(value);
+}
+
+std::vector<EventBatcher::Event> EventBatcher::collect()
+{
+	std::vector<Event> events;
+	std::lock_guard<std::mutex> eventsGuard(_eventsMutex);
+	if(_events.empty()) return events;
+	events.swap(_events);
+	_eventIndex.clear();
+	_statistics.batches++;
+	_statistics.events += events.size();
+	if(events.size() > _statistics.maxBatchSize) _statistics.maxBatchSize = events.size();
+	return events;
+}
+
+EventBatcher::Statistics EventBatcher::getStatistics()
+{
+	std::lock_guard<std::mutex> eventsGuard(_eventsMutex);
+	return _statistics;
+}
+
+}
@@ -0,0 +1,86 @@
+/* Copyright 2013-2019 Homegear GmbH
+ *
+ * Homegear is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Homegear is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Homegear.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef EVENTBATCHER_H_
+#define EVENTBATCHER_H_
+
+#include <homegear-base/BaseLib.h>
+
+#include <map>
+#include <mutex>
+
+namespace MyFamily
+{
+
+/**
+ * Collects value updates of peers until they are published. All updates of one peer and channel are combined into one event
+ * with one entry per value key. When a key is updated again before the event is published, only the newest value is kept.
+ * Events are returned in the order of their first update.
+ */
+class EventBatcher
+{
+public:
+	struct Statistics
+	{
+		uint64_t updates = 0;
+		uint64_t coalesced = 0;
+		uint64_t batches = 0;
+		uint64_t events = 0;
+		uint32_t maxBatchSize = 0; //In events
+	};
+
+	struct Event
+	{
+		uint64_t peerId = 0;
+		int32_t channel = 0;
+		std::shared_ptr<std::vector<std::string>> valueKeys;
+		std::shared_ptr<std::vector<BaseLib::PVariable>> values;
+	};
+
+	EventBatcher() = default;
+	virtual ~EventBatcher() = default;
+
+	void add(uint64_t peerId, int32_t channel, const std::string& valueKey, const BaseLib::PVariable& value);
+
+	/**
+	 * Removes and returns all pending events.
+	 */
+	std::vector<Event> collect();
+
+	Statistics getStatistics();
+protected:
+	std::mutex _eventsMutex;
+	std::vector<Event> _events;
+	std::map<std::pair<uint64_t, int32_t>, size_t> _eventIndex; //Index of the pending event of a peer and channel in _events
+	Statistics _statistics;
+};
+
+}
+
+#endif
@@ -0,0 +1,154 @@
+/* Copyright 2013-2019 Homegear GmbH
+ *
+ * Homegear is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Homegear is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Homegear.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "FrameCombiner.h"
+
+#include <chrono>
+
+namespace MyFamily
+{
+
+FrameCombiner::FrameCombiner(int64_t window, const std::vector<std::string>& interfaceIds) : _window(window), _interfaceIds(interfaceIds)
+{
+	if(_interfaceIds.size() > 64) _interfaceIds.resize(64);
+	_statistics.resize(_interfaceIds.size());
+}
+
+int64_t FrameCombiner::getTimeMilliseconds()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool FrameCombiner::isCopy(uint64_t frameKey, const std::string& interfaceId, uint8_t rssi)
+{
+	int32_t interfaceIndex = -1;
+	for(uint32_t i = 0; i < _interfaceIds.size(); i++)
+	{
+		if(_interfaceIds[i] == interfaceId)
+		{
+			interfaceIndex = i;
+			break;
+		}
+	}
+	if(interfaceIndex == -1) return false;
+	uint64_t interfaceBit = 1ull << interfaceIndex;
+
+	int64_t now = getTimeMilliseconds();
+	uint64_t hash = frameKey * 0x9E3779B97F4A7C15ull;
+	uint32_t index = (uint32_t)(hash >> 32) & (_tableSize - 1);
+
+	std::lock_guard<std::mutex> tableGuard(_tableMutex);
+	Slot* freeSlot = nullptr;
+	for(uint32_t i = 0; i < _maxProbes; i++)
+	{
+		Slot& slot = _table[(index + i) & (_tableSize - 1)];
+		if(slot.time != 0 && slot.frameKey == frameKey)
+		{
+			if(now - slot.time >= _window)
+			{
+				//Expired, so this is a new transmission of the same frame.
+				freeSlot = &slot;
+				break;
+			}
+
+			slot.time = now;
+			//Repeats on the same interface are not combined. They are handled by the repeat filter.
+			if(slot.receivers & interfaceBit) return false;
+
+			slot.receivers |= interfaceBit;
+			_statistics[interfaceIndex].copies++;
+			if(rssi < slot.bestRssi)
+			{
+				slot.bestRssi = rssi;
+				slot.bestInterface = interfaceIndex;
+				_statistics[interfaceIndex].betterCopies++;
+			}
+			_combinedFrames++;
+			return true;
+		}
+		if(!freeSlot || slot.time < freeSlot->time) freeSlot = &slot; //Empty or oldest slot
+	}
+
+	freeSlot->frameKey = frameKey;
+	freeSlot->time = now;
+	freeSlot->receivers = interfaceBit;
+	freeSlot->bestRssi = rssi;
+	freeSlot->bestInterface = interfaceIndex;
+	_statistics[interfaceIndex].first++;
+	return false;
+}
+
+FrameCombiner::Slot* FrameCombiner::findSlot(uint64_t frameKey)
+{
+	uint64_t hash = frameKey * 0x9E3779B97F4A7C15ull;
+	uint32_t index = (uint32_t)(hash >> 32) & (_tableSize - 1);
+	for(uint32_t i = 0; i < _maxProbes; i++)
+	{
+		Slot& slot = _table[(index + i) & (_tableSize - 1)];
+		if(slot.time != 0 && slot.frameKey == frameKey) return &slot;
+	}
+	return nullptr;
+}
+
+bool FrameCombiner::getFrameInfo(uint64_t frameKey, FrameInfo& frameInfo)
+{
+	int64_t now = getTimeMilliseconds();
+	std::lock_guard<std::mutex> tableGuard(_tableMutex);
+	Slot* slot = findSlot(frameKey);
+	if(!slot || now - slot->time >= _window) return false;
+
+	frameInfo.receivers.clear();
+	for(uint32_t i = 0; i < _interfaceIds.size(); i++)
+	{
+		if(slot->receivers & (1ull << i)) frameInfo.receivers.push_back(_interfaceIds[i]);
+	}
+	frameInfo.bestInterfaceId = slot->bestInterface >= 0 ? _interfaceIds.at(slot->bestInterface) : "";
+	frameInfo.bestRssi = slot->bestRssi;
+	return true;
+}
+
+uint64_t FrameCombiner::getCombinedFrames()
+{
+	std::lock_guard<std::mutex> tableGuard(_tableMutex);
+	return _combinedFrames;
+}
+
+std::vector<std::pair<std::string, FrameCombiner::InterfaceStatistics>> FrameCombiner::getStatistics()
+{
+	std::lock_guard<std::mutex> tableGuard(_tableMutex);
+	std::vector<std::pair<std::string, InterfaceStatistics>> statistics;
+	statistics.reserve(_interfaceIds.size());
+	for(uint32_t i = 0; i < _interfaceIds.size(); i++)
+	{
+		statistics.emplace_back(_interfaceIds[i], _statistics[i]);
+	}
+	return statistics;
+}
+
+}
@@ -0,0 +1,118 @@
+/* Copyright 2013-2019 Homegear GmbH
+ *
+ * Homegear is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Homegear is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Homegear.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef FRAMECOMBINER_H_
+#define FRAMECOMBINER_H_
+
+#include <cstdint>
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace MyFamily
+{
+
+/**
+ * Combines copies of the same frame received by several interfaces. The first copy of a frame is processed, copies received by
+ * other interfaces within "window" milliseconds are dropped. For every frame the receiving interfaces and the best RSSI are
+ * recorded. Uses the same open-addressed table layout as RepeatFilter.
+ */
+class FrameCombiner
+{
+public:
+	struct InterfaceStatistics
+	{
+		uint64_t first = 0; //Number of frames this interface received first
+		uint64_t copies = 0; //Number of copies received after another interface
+		uint64_t betterCopies = 0; //Number of copies with a better RSSI than all earlier copies
+	};
+
+	struct FrameInfo
+	{
+		std::vector<std::string> receivers;
+		std::string bestInterfaceId;
+		uint8_t bestRssi = 0;
+	};
+
+	/**
+	 * @param window The combining window in milliseconds.
+	 * @param interfaceIds The IDs of all interfaces. At most 64 interfaces are supported, additional interfaces are ignored.
+	 */
+	FrameCombiner(int64_t window, const std::vector<std::string>& interfaceIds);
+	virtual ~FrameCombiner() = default;
+
+	/**
+	 * Records a received frame.
+	 *
+	 * @param frameKey A value uniquely identifying the frame content (see MyPacket::getFrameKey() and MyCulTxPacket::getFrameKey()).
+	 * @param interfaceId The ID of the receiving interface.
+	 * @param rssi The RSSI as returned by getRssi() of the packet (smaller is better).
+	 * @return Returns true when another interface already received the frame and this copy should be dropped.
+	 */
+	bool isCopy(uint64_t frameKey, const std::string& interfaceId, uint8_t rssi);
+
+	/**
+	 * Returns the receivers and the best RSSI of a frame received within the combining window.
+	 *
+	 * @return Returns false when the frame is unknown or the window has passed.
+	 */
+	bool getFrameInfo(uint64_t frameKey, FrameInfo& frameInfo);
+
+	int64_t getWindow() { return _window; }
+	uint64_t getCombinedFrames();
+	std::vector<std::pair<std::string, InterfaceStatistics>> getStatistics();
+protected:
+	static const uint32_t _tableSize = 64; //Needs to be a power of two
+	static const uint32_t _maxProbes = 8;
+
+	struct Slot
+	{
+		uint64_t frameKey = 0;
+		int64_t time = 0;
+		uint64_t receivers = 0; //Bit n is set when interface n received the frame
+		uint8_t bestRssi = 0;
+		int32_t bestInterface = -1;
+	};
+
+	int64_t _window = 0;
+	std::vector<std::string> _interfaceIds;
+	std::mutex _tableMutex;
+	std::array<Slot, _tableSize> _table;
+	std::vector<InterfaceStatistics> _statistics;
+	uint64_t _combinedFrames = 0;
+
+	static int64_t getTimeMilliseconds();
+	Slot* findSlot(uint64_t frameKey);
+};
+
+}
+
+#endif
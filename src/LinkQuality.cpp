@@ -0,0 +1,134 @@
+/* Copyright 2013-2019 Homegear GmbH
+ *
+ * Homegear is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Homegear is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Homegear.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "LinkQuality.h"
+
+#include <algorithm>
+
+namespace MyFamily
+{
+
+uint32_t LinkQuality::Receiver::getFramesPerHour(int64_t time) const
+{
+	if(frames == 0) return 0;
+	int64_t elapsed = time - hourStart;
+	if(elapsed < 0) elapsed = 0;
+	if(elapsed >= 2 * _hour) return 0;
+	if(elapsed >= _hour) return (uint32_t)((int64_t)framesCurrentHour * (2 * _hour - elapsed) / _hour);
+	return framesCurrentHour + (uint32_t)((int64_t)framesPreviousHour * (_hour - elapsed) / _hour);
+}
+
+void LinkQuality::addSample(const std::string& interfaceId, uint8_t rssi, int64_t time)
+{
+	std::lock_guard<std::mutex> receiversGuard(_receiversMutex);
+	Receiver* receiver = nullptr;
+	for(auto& element : _receivers)
+	{
+		if(element.frames > 0 && element.interfaceId == interfaceId)
+		{
+			receiver = &element;
+			break;
+		}
+		if(!receiver || element.lastSeen < receiver->lastSeen) receiver = &element; //Unused receivers have lastSeen 0
+	}
+
+	if(receiver->frames == 0 || receiver->interfaceId != interfaceId)
+	{
+		*receiver = Receiver();
+		receiver->interfaceId = interfaceId;
+		receiver->firstSeen = time;
+		receiver->hourStart = time;
+	}
+
+	if(rssi != 0)
+	{
+		if(receiver->rssiSamples == 0)
+		{
+			receiver->averageRssi = (int32_t)rssi * 16;
+			receiver->bestRssi = rssi;
+			receiver->worstRssi = rssi;
+		}
+		else
+		{
+			receiver->averageRssi += ((int32_t)rssi * 16 - receiver->averageRssi) / 8;
+			if(rssi < receiver->bestRssi) receiver->bestRssi = rssi;
+			if(rssi > receiver->worstRssi) receiver->worstRssi = rssi;
+		}
+		int32_t bucket = ((int32_t)rssi - 30) / 10;
+		receiver->histogram[std::min(std::max(bucket, 0), (int32_t)histogramSize - 1)]++;
+		receiver->rssiSamples++;
+	}
+
+	int64_t elapsed = time - receiver->hourStart;
+	if(elapsed >= _hour)
+	{
+		receiver->framesPreviousHour = elapsed < 2 * _hour ? receiver->framesCurrentHour : 0;
+		receiver->framesCurrentHour = 0;
+		receiver->hourStart += (elapsed / _hour) * _hour;
+	}
+
+	receiver->frames++;
+	receiver->framesCurrentHour++;
+	receiver->lastSeen = time;
+}
+
+std::vector<LinkQuality::Receiver> LinkQuality::getReceivers()
+{
+	std::vector<Receiver> receivers;
+	{
+		std::lock_guard<std::mutex> receiversGuard(_receiversMutex);
+		for(auto& receiver : _receivers)
+		{
+			if(receiver.frames > 0) receivers.push_back(receiver);
+		}
+	}
+	//Receivers without RSSI last
+	std::sort(receivers.begin(), receivers.end(), [](const Receiver& a, const Receiver& b) { return (a.rssiSamples > 0 && b.rssiSamples == 0) || ((a.rssiSamples > 0) == (b.rssiSamples > 0) && a.averageRssi < b.averageRssi); });
+	return receivers;
+}
+
+std::string LinkQuality::getBestInterface(int64_t time, int64_t maxAge)
+{
+	std::lock_guard<std::mutex> receiversGuard(_receiversMutex);
+	const Receiver* bestReceiver = nullptr;
+	for(auto& receiver : _receivers)
+	{
+		if(receiver.frames == 0 || time - receiver.lastSeen > maxAge) continue;
+		if(!bestReceiver || (receiver.rssiSamples > 0 && (bestReceiver->rssiSamples == 0 || receiver.averageRssi < bestReceiver->averageRssi))) bestReceiver = &receiver;
+	}
+	return bestReceiver ? bestReceiver->interfaceId : std::string();
+}
+
+void LinkQuality::clear()
+{
+	std::lock_guard<std::mutex> receiversGuard(_receiversMutex);
+	_receivers.fill(Receiver());
+}
+
+}
@@ -0,0 +1,109 @@
+/* Copyright 2013-2019 Homegear GmbH
+ *
+ * Homegear is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Homegear is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Homegear.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef LINKQUALITY_H_
+#define LINKQUALITY_H_
+
+#include <cstdint>
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace MyFamily
+{
+
+/**
+ * Link statistics of one peer, kept separately for every interface receiving its frames. Adding a sample doesn't allocate memory
+ * (except when an interface is seen for the first time), so every received frame can be recorded. RSSI values use the
+ * representation of MyPacket::getRssi(): the absolute value in dBm, smaller is better. 0 means the frame has no RSSI (CULTX), so
+ * only the frame counters are updated.
+ */
+class LinkQuality
+{
+public:
+	static const uint32_t histogramSize = 8;
+
+	struct Receiver
+	{
+		std::string interfaceId;
+		uint64_t frames = 0;
+		uint64_t rssiSamples = 0;
+		int32_t averageRssi = 0; //Exponentially weighted moving average in 1/16 dBm
+		uint8_t bestRssi = 0;
+		uint8_t worstRssi = 0;
+		/**
+		 * Frame count per RSSI range: < 40, 40 - 49, 50 - 59, ..., 90 - 99 and >= 100 dBm.
+		 */
+		std::array<uint32_t, histogramSize> histogram{};
+		int64_t firstSeen = 0; //In milliseconds since epoch
+		int64_t lastSeen = 0; //In milliseconds since epoch
+		int64_t hourStart = 0; //In milliseconds since epoch
+		uint32_t framesCurrentHour = 0;
+		uint32_t framesPreviousHour = 0;
+
+		/**
+		 * Returns the number of frames received during the last 60 minutes. The count of the previous hour is weighted by the
+		 * part of it still within this period.
+		 */
+		uint32_t getFramesPerHour(int64_t time) const;
+	};
+
+	LinkQuality() = default;
+	virtual ~LinkQuality() = default;
+
+	/**
+	 * Records a frame received by an interface. When the table is full, the receiver seen least recently is replaced.
+	 */
+	void addSample(const std::string& interfaceId, uint8_t rssi, int64_t time);
+
+	/**
+	 * Returns all receivers sorted by average RSSI (best first).
+	 */
+	std::vector<Receiver> getReceivers();
+
+	/**
+	 * Returns the ID of the interface with the best average RSSI among the interfaces which received a frame within maxAge
+	 * milliseconds or an empty string. Interfaces without RSSI are only returned when no other interface qualifies.
+	 */
+	std::string getBestInterface(int64_t time, int64_t maxAge);
+
+	void clear();
+protected:
+	static const uint32_t _maxReceivers = 4;
+	static const int64_t _hour = 3600000;
+
+	std::mutex _receiversMutex;
+	std::array<Receiver, _maxReceivers> _receivers;
+};
+
+}
+
+#endif
@@ -30,7 +30,11 @@
 #include "MyCentral.h"
 #include "GD.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
+#include <set>
+#include <tuple>
 
 namespace MyFamily {
 
@@ -61,6 +65,39 @@ void MyCentral::dispose(bool wait)
 			//Just to make sure cycle through all physical devices. If event handler is not removed => segfault
 			i->second->removeEventHandler(_physicalInterfaceEventhandlers[i->first]);
 		}
+
+		for(auto& receiveQueue : _receiveQueues)
+		{
+			receiveQueue->stop();
+		}
+		for(auto& dispatchThread : _dispatchThreads)
+		{
+			_bl->threadManager.join(dispatchThread);
+		}
+
+		if(eventBatchingEnabled())
+		{
+			{
+				std::lock_guard<std::mutex> eventBatchThreadGuard(_eventBatchThreadMutex);
+				_stopEventBatchThread = true;
+			}
+			_eventBatchThreadConditionVariable.notify_all();
+			_bl->threadManager.join(_eventBatchThread);
+			publishBatchedEvents();
+		}
+
+		if(writeBehindEnabled())
+		{
+			{
+				std::lock_guard<std::mutex> dirtyPeersGuard(_dirtyPeersMutex);
+				_stopWriteBehindThread = true;
+			}
+			_dirtyPeersConditionVariable.notify_all();
+			_bl->threadManager.join(_writeBehindThread);
+			flushDirtyValues();
+		}
+
+		writePeerStateFile();
 	}
     catch(const std::exception& ex)
     {
@@ -68,229 +105,1357 @@ void MyCentral::dispose(bool wait)
     }
 }
 
-void MyCentral::init()
-{
-	try
-	{
-		if(_initialized) return; //Prevent running init two times
-		_initialized = true;
+void MyCentral::init()
+{
+	try
+	{
+		if(_initialized) return; //Prevent running init two times
+		_initialized = true;
+
+		int32_t receiveQueueSize = GD::family->getSettingInteger("receiveQueueSize", 1000);
+		int32_t dispatchThreadCount = GD::family->getSettingInteger("dispatchThreads", 1);
+		if(dispatchThreadCount > 0)
+		{
+			if(receiveQueueSize < 1) receiveQueueSize = 1;
+			if(dispatchThreadCount > 16) dispatchThreadCount = 16;
+			PacketQueue::OverflowPolicy overflowPolicy = PacketQueue::parseOverflowPolicy(GD::family->getSettingString("receiveQueueFullPolicy", "dropOldest"));
+			_receiveQueues.reserve(dispatchThreadCount);
+			for(int32_t i = 0; i < dispatchThreadCount; i++)
+			{
+				_receiveQueues.push_back(std::make_shared<PacketQueue>(receiveQueueSize, overflowPolicy));
+			}
+			_dispatchThreads.resize(dispatchThreadCount);
+			for(int32_t i = 0; i < dispatchThreadCount; i++)
+			{
+				_bl->threadManager.start(_dispatchThreads.at(i), true, &MyCentral::dispatchThread, this, i);
+			}
+		}
+
+		_peerStateFile = GD::family->getSettingString("peerStateFile", "");
+
+		_changeDetectionSettings.temperatureDeadband = GD::family->getSettingInteger("temperatureDeadband", 0);
+		_changeDetectionSettings.humidityDeadband = GD::family->getSettingInteger("humidityDeadband", 0);
+		_changeDetectionSettings.relativeDeadband = GD::family->getSettingInteger("relativeDeadband", 0);
+		_changeDetectionSettings.heartbeat = GD::family->getSettingInteger("sensorHeartbeat", 900);
+
+		_writeBehindInterval = GD::family->getSettingInteger("writeBehindInterval", 1000);
+		if(_writeBehindInterval > 0)
+		{
+			int32_t writeBehindThreshold = GD::family->getSettingInteger("writeBehindThreshold", 100);
+			_writeBehindThreshold = writeBehindThreshold > 0 ? writeBehindThreshold : 1;
+			_bl->threadManager.start(_writeBehindThread, true, &MyCentral::writeBehindThread, this);
+		}
+
+		_eventBatchingWindow = GD::family->getSettingInteger("eventBatchingWindow", 50);
+		if(_eventBatchingWindow > 0)
+		{
+			std::vector<std::string> excludedKeys = BaseLib::HelperFunctions::splitAll(GD::family->getSettingString("eventBatchingExcludedKeys", ""), ',');
+			for(auto& key : excludedKeys)
+			{
+				BaseLib::HelperFunctions::trim(key);
+				BaseLib::HelperFunctions::toUpper(key);
+				if(!key.empty()) _eventBatchingExcludedKeys.insert(key);
+			}
+			_eventBatcher = std::make_shared<EventBatcher>();
+			_bl->threadManager.start(_eventBatchThread, true, &MyCentral::eventBatchThread, this);
+		}
+
+		_txInterfaceSelection = GD::family->getSettingInteger("txInterfaceSelection", 0) != 0 && GD::physicalInterfaces.size() > 1;
+		_setValueWaitTime = GD::family->getSettingInteger("setValueWaitTime", 0);
+		if(_setValueWaitTime < 0) _setValueWaitTime = 0;
+
+		int32_t repeatSuppressionWindow = GD::family->getSettingInteger("repeatSuppressionWindow", 300);
+		if(repeatSuppressionWindow > 0)
+		{
+			for(auto& interface : GD::physicalInterfaces)
+			{
+				_repeatFilters.emplace(interface.first, std::make_shared<RepeatFilter>(repeatSuppressionWindow));
+			}
+		}
+
+		int32_t combiningWindow = GD::family->getSettingInteger("combiningWindow", 100);
+		if(combiningWindow > 0 && GD::physicalInterfaces.size() > 1)
+		{
+			std::vector<std::string> interfaceIds;
+			interfaceIds.reserve(GD::physicalInterfaces.size());
+			for(auto& interface : GD::physicalInterfaces)
+			{
+				interfaceIds.push_back(interface.first);
+			}
+			_frameCombiner = std::make_shared<FrameCombiner>(combiningWindow, interfaceIds);
+		}
+
+		_localRpcMethods.emplace("getStatistics", std::bind(&MyCentral::getStatistics, this, std::placeholders::_1, std::placeholders::_2));
+		_localRpcMethods.emplace("getUnknownSenders", std::bind(&MyCentral::getUnknownSenders, this, std::placeholders::_1, std::placeholders::_2));
+		_localRpcMethods.emplace("getDutyCycle", std::bind(&MyCentral::getDutyCycle, this, std::placeholders::_1, std::placeholders::_2));
+		_localRpcMethods.emplace("getLinkQuality", std::bind(&MyCentral::getLinkQuality, this, std::placeholders::_1, std::placeholders::_2));
+		_localRpcMethods.emplace("setScene", std::bind(&MyCentral::setScene, this, std::placeholders::_1, std::placeholders::_2));
+
+		for(std::map<std::string, std::shared_ptr<IIntertechnoInterface>>::iterator i = GD::physicalInterfaces.begin(); i != GD::physicalInterfaces.end(); ++i)
+		{
+			_physicalInterfaceEventhandlers[i->first] = i->second->addEventHandler((BaseLib::Systems::IPhysicalInterface::IPhysicalInterfaceEventSink*)this);
+		}
+	}
+	catch(const std::exception& ex)
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+}
+
+void MyCentral::loadVariables()
+{
+	try
+	{
+		std::shared_ptr<BaseLib::Database::DataTable> rows = _bl->db->getDeviceVariables(_deviceId);
+		for(BaseLib::Database::DataTable::iterator row = rows->begin(); row != rows->end(); ++row)
+		{
+			_variableDatabaseIDs[row->second.at(2)->intValue] = row->second.at(0)->intValue;
+			switch(row->second.at(2)->intValue)
+			{
+			case 0:
+				_peerGeneration = row->second.at(3)->intValue;
+				break;
+			}
+		}
+	}
+	catch(const std::exception& ex)
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+}
+
+void MyCentral::saveVariables()
+{
+	try
+	{
+		if(_deviceId == 0) return;
+		saveVariable(0, (int64_t)_peerGeneration.load());
+	}
+	catch(const std::exception& ex)
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+}
+
+void MyCentral::peersChanged()
+{
+	_peerGeneration++;
+	saveVariables(); //Always saves the latest generation, so concurrent calls don't need to be ordered.
+}
+
+void MyCentral::writePeerStateFile()
+{
+	try
+	{
+		if(_peerStateFile.empty()) return;
+		PPeerSnapshot snapshot;
+		uint64_t generation = 0;
+		{
+			std::lock_guard<std::mutex> snapshotGuard(_peerSnapshotWriteMutex);
+			if(_peerGeneration == _peerStateFileGeneration) return;
+			snapshot = getPeerSnapshot();
+			generation = _peerGeneration;
+		}
+
+		std::vector<PeerStateFile::PeerEntry> entries;
+		entries.reserve(snapshot->peersById.size());
+		for(auto& peer : snapshot->peersById)
+		{
+			entries.push_back(peer.second->getIndexEntry());
+		}
+		//The snapshot references all peers. deletePeer() waits until it holds the last reference, so don't keep it while
+		//writing the file.
+		snapshot.reset();
+
+		if(PeerStateFile::write(_peerStateFile, generation, entries))
+		{
+			std::lock_guard<std::mutex> snapshotGuard(_peerSnapshotWriteMutex);
+			_peerStateFileGeneration = generation;
+		}
+		else GD::out.printError("Error: Could not write peer state file " + _peerStateFile + ".");
+	}
+	catch(const std::exception& ex)
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+}
+
+void MyCentral::loadPeers()
+{
+	try
+	{
+		auto startTime = std::chrono::steady_clock::now();
+		PeerLoadJob job;
+		job.lazy = GD::family->getSettingInteger("lazyPeerLoading", 0) != 0;
+		if(!_peerStateFile.empty() && PeerStateFile::read(_peerStateFile, _peerGeneration, job.stateFileEntries))
+		{
+			_peerStateFileGeneration = _peerGeneration;
+			job.peers.reserve(job.stateFileEntries.size());
+			for(auto& entry : job.stateFileEntries)
+			{
+				job.peers.push_back(std::shared_ptr<MyPeer>(new MyPeer(entry.id, entry.address, entry.serialNumber, _deviceId, this)));
+			}
+		}
+		else
+		{
+			if(!_peerStateFile.empty()) GD::out.printInfo("Info: Peer state file " + _peerStateFile + " is missing or outdated. Loading peers from database.");
+			std::shared_ptr<BaseLib::Database::DataTable> rows = _bl->db->getPeers(_deviceId);
+			job.peers.reserve(rows->size());
+			for(BaseLib::Database::DataTable::iterator row = rows->begin(); row != rows->end(); ++row)
+			{
+				int32_t peerID = row->second.at(0)->intValue;
+				job.peers.push_back(std::shared_ptr<MyPeer>(new MyPeer(peerID, row->second.at(2)->intValue, row->second.at(3)->textValue, _deviceId, this)));
+			}
+		}
+		job.loaded.resize(job.peers.size(), 0);
+
+		//Peers are independent of each other, so they are loaded in parallel. The calling thread takes part in loading, so
+		//loading also works when no additional threads can be started.
+		int32_t loaderThreadCount = GD::family->getSettingInteger("peerLoaderThreads", 4);
+		if(loaderThreadCount > 16) loaderThreadCount = 16;
+		if(loaderThreadCount > (int32_t)job.peers.size()) loaderThreadCount = job.peers.size();
+		std::vector<std::thread> loaderThreads(loaderThreadCount > 1 ? loaderThreadCount - 1 : 0);
+		for(auto& loaderThread : loaderThreads)
+		{
+			_bl->threadManager.start(loaderThread, true, &MyCentral::loadPeersThread, this, &job);
+		}
+		loadPeersThread(&job);
+		for(auto& loaderThread : loaderThreads)
+		{
+			_bl->threadManager.join(loaderThread);
+		}
+
+		std::shared_ptr<PeerSnapshot> snapshot = std::make_shared<PeerSnapshot>();
+		uint32_t loadedPeers = 0;
+		{
+			std::lock_guard<std::mutex> peersGuard(_peersMutex);
+			for(uint32_t i = 0; i < job.peers.size(); i++)
+			{
+				if(!job.loaded.at(i)) continue;
+				PMyPeer& peer = job.peers.at(i);
+				if(!peer->getSerialNumber().empty()) _peersBySerial[peer->getSerialNumber()] = peer;
+				_peersById[peer->getID()] = peer;
+				_peers[peer->getAddress()] = peer;
+				snapshot->add(peer);
+				loadedPeers++;
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> snapshotGuard(_peerSnapshotWriteMutex);
+			std::atomic_store(&_peerSnapshot, PPeerSnapshot(snapshot));
+		}
+
+		int64_t loadTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+		GD::out.printInfo("Info: Loaded " + std::to_string(loadedPeers) + " Intertechno peers in " + std::to_string(loadTime) + " ms using " + std::to_string(loaderThreads.size() + 1) + " threads" + (job.stateFileEntries.empty() ? "" : " from peer state file") + (job.lazy ? " (lazy)" : "") + (loadedPeers > 0 ? " (" + std::to_string(loadTime * 1000 / loadedPeers) + " ms per 1000 peers)." : "."));
+	}
+	catch(const std::exception& ex)
+    {
+    	GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+    }
+}
+
+void MyCentral::loadPeersThread(PeerLoadJob* job)
+{
+	for(uint32_t i = job->nextPeer++; i < job->peers.size(); i = job->nextPeer++)
+	{
+		try
+		{
+			PMyPeer& peer = job->peers.at(i);
+			GD::out.printMessage("Loading Intertechno peer " + std::to_string(peer->getID()));
+			if(!job->stateFileEntries.empty())
+			{
+				//The peer state file only contains the index. Unless peers are loaded lazily, the rest is loaded here, before the
+				//peer is published. Not all BaseLib methods materialize the peer (e. g. name lookups, getAllConfig() or
+				//getServiceMessages()), so a published peer has to be complete.
+				job->loaded.at(i) = peer->loadIndex(job->stateFileEntries.at(i));
+				if(job->loaded.at(i) && !job->lazy) peer->materialize(this);
+			}
+			else job->loaded.at(i) = (job->lazy ? peer->loadIndex(this) : peer->load(this)) && peer->getRpcDevice();
+		}
+		catch(const std::exception& ex)
+		{
+			GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+		}
+	}
+}
+
+std::shared_ptr<MyPeer> MyCentral::getPeer(uint64_t id)
+{
+	try
+	{
+		PPeerSnapshot snapshot = getPeerSnapshot();
+		auto peerIterator = snapshot->peersById.find(id);
+		if(peerIterator != snapshot->peersById.end())
+		{
+			peerIterator->second->materialize(this);
+			return peerIterator->second;
+		}
+	}
+	catch(const std::exception& ex)
+    {
+        GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+    }
+    return std::shared_ptr<MyPeer>();
+}
+
+std::shared_ptr<MyPeer> MyCentral::getPeer(int32_t address)
+{
+	try
+	{
+		PPeerSnapshot snapshot = getPeerSnapshot();
+		auto peerIterator = snapshot->peersByAddress.find(address);
+		if(peerIterator != snapshot->peersByAddress.end())
+		{
+			peerIterator->second->materialize(this);
+			return peerIterator->second;
+		}
+	}
+	catch(const std::exception& ex)
+    {
+        GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+    }
+    return std::shared_ptr<MyPeer>();
+}
+
+std::shared_ptr<MyPeer> MyCentral::getPeer(std::string serialNumber)
+{
+	try
+	{
+		PPeerSnapshot snapshot = getPeerSnapshot();
+		auto peerIterator = snapshot->peersBySerial.find(serialNumber);
+		if(peerIterator != snapshot->peersBySerial.end())
+		{
+			peerIterator->second->materialize(this);
+			return peerIterator->second;
+		}
+	}
+	catch(const std::exception& ex)
+    {
+        GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+    }
+    return std::shared_ptr<MyPeer>();
+}
+
+void MyCentral::PeerSnapshot::add(const PMyPeer& peer)
+{
+	remove(peer->getID());
+
+	if(!peer->getSerialNumber().empty()) peersBySerial[peer->getSerialNumber()] = peer;
+	peersById[peer->getID()] = peer;
+	peersByAddress[peer->getAddress()] = peer;
+
+	if(!isIndexedDeviceType(peer->getDeviceType()) || !peer->getPhysicalInterface()) return;
+	std::string interfaceId = peer->getPhysicalInterface()->getID();
+	uint64_t key = getAddressIndexKey(peer->getDeviceType(), peer->getAddress());
+	addressIndex[interfaceId][key] = peer;
+	addressIndexKeys[peer->getID()] = std::make_pair(interfaceId, key);
+}
+
+void MyCentral::PeerSnapshot::remove(uint64_t peerId)
+{
+	auto peerIterator = peersById.find(peerId);
+	if(peerIterator == peersById.end()) return;
+	PMyPeer peer = peerIterator->second;
+	peersById.erase(peerIterator);
+
+	auto serialIterator = peersBySerial.find(peer->getSerialNumber());
+	if(serialIterator != peersBySerial.end() && serialIterator->second->getID() == peerId) peersBySerial.erase(serialIterator);
+	auto addressIterator = peersByAddress.find(peer->getAddress());
+	if(addressIterator != peersByAddress.end() && addressIterator->second->getID() == peerId) peersByAddress.erase(addressIterator);
+
+	auto keyIterator = addressIndexKeys.find(peerId);
+	if(keyIterator == addressIndexKeys.end()) return;
+	auto interfaceIterator = addressIndex.find(keyIterator->second.first);
+	if(interfaceIterator != addressIndex.end())
+	{
+		auto indexIterator = interfaceIterator->second.find(keyIterator->second.second);
+		if(indexIterator != interfaceIterator->second.end() && indexIterator->second->getID() == peerId) interfaceIterator->second.erase(indexIterator);
+	}
+	addressIndexKeys.erase(keyIterator);
+}
+
+PMyPeer MyCentral::PeerSnapshot::getPeerByDerivedAddress(const std::string& interfaceId, uint32_t deviceType, int32_t address, bool anyInterface) const
+{
+	uint64_t key = getAddressIndexKey(deviceType, address);
+	auto interfaceIterator = addressIndex.find(interfaceId);
+	if(interfaceIterator != addressIndex.end())
+	{
+		auto peerIterator = interfaceIterator->second.find(key);
+		if(peerIterator != interfaceIterator->second.end()) return peerIterator->second;
+	}
+	if(!anyInterface) return PMyPeer();
+
+	//Peers assigned to the receiving interface are preferred. Only then the other interfaces are searched.
+	for(auto& interfaceEntry : addressIndex)
+	{
+		if(interfaceEntry.first == interfaceId) continue;
+		auto peerIterator = interfaceEntry.second.find(key);
+		if(peerIterator != interfaceEntry.second.end()) return peerIterator->second;
+	}
+	return PMyPeer();
+}
+
+void MyCentral::publishPeer(const PMyPeer& peer)
+{
+	try
+	{
+		if(!peer) return;
+		{
+			std::lock_guard<std::mutex> snapshotGuard(_peerSnapshotWriteMutex);
+			std::shared_ptr<PeerSnapshot> snapshot = std::make_shared<PeerSnapshot>(*getPeerSnapshot());
+			snapshot->add(peer);
+			std::atomic_store(&_peerSnapshot, PPeerSnapshot(snapshot));
+		}
+		peersChanged();
+	}
+	catch(const std::exception& ex)
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+}
+
+void MyCentral::unpublishPeer(uint64_t peerId)
+{
+	try
+	{
+		{
+			std::lock_guard<std::mutex> snapshotGuard(_peerSnapshotWriteMutex);
+			std::shared_ptr<PeerSnapshot> snapshot = std::make_shared<PeerSnapshot>(*getPeerSnapshot());
+			snapshot->remove(peerId);
+			std::atomic_store(&_peerSnapshot, PPeerSnapshot(snapshot));
+		}
+		peersChanged();
+	}
+	catch(const std::exception& ex)
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+}
+
+std::pair<int32_t, int32_t> MyCentral::getOldItGroupStartCodeAndChannel(int32_t address)
+{
+	std::pair<int32_t, int32_t> returnValue(0, 0);
+	try
+	{
+		int32_t groupCode = (address & 0x3C) >> 2;
+		int32_t groupStartCode = 0;
+		int32_t channel = 0;
+		switch(groupCode)
+		{
+		case 0:
+			channel = 1;
+			groupStartCode = 0;
+			break;
+		case 8:
+			channel = 2;
+			groupStartCode = 0;
+			break;
+		case 4:
+			channel = 3;
+			groupStartCode = 0;
+			break;
+		case 12:
+			channel = 4;
+			groupStartCode = 0;
+			break;
+		case 2:
+			channel = 1;
+			groupStartCode = 2;
+			break;
+		case 10:
+			channel = 2;
+			groupStartCode = 2;
+			break;
+		case 6:
+			channel = 3;
+			groupStartCode = 2;
+			break;
+		case 14:
+			channel = 4;
+			groupStartCode = 2;
+			break;
+		case 1:
+			channel = 1;
+			groupStartCode = 1;
+			break;
+		case 9:
+			channel = 2;
+			groupStartCode = 1;
+			break;
+		case 5:
+			channel = 3;
+			groupStartCode = 1;
+			break;
+		case 13:
+			channel = 4;
+			groupStartCode = 1;
+			break;
+		case 3:
+			channel = 1;
+			groupStartCode = 3;
+			break;
+		case 11:
+			channel = 2;
+			groupStartCode = 3;
+			break;
+		case 7:
+			channel = 3;
+			groupStartCode = 3;
+			break;
+		case 15:
+			channel = 4;
+			groupStartCode = 3;
+			break;
+		default:
+			channel = 0;
+		}
+		returnValue.first = groupStartCode;
+		returnValue.second = channel;
+	}
+	catch(const std::exception& ex)
+    {
+        GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+    }
+    return returnValue;
+}
+
+
+bool MyCentral::onPacketReceived(std::string& senderId, std::shared_ptr<BaseLib::Systems::Packet> packet)
+{
+	try
+	{
+		if(_disposing || !packet) return false;
+
+		//The peer is resolved here on the interface thread. Lookups only read the peer snapshot, so this doesn't block.
+		//Copies of a frame received by another interface are still resolved, so the link statistics of the peer contain every
+		//interface receiving it.
+		PMyPeer peer;
+		bool combinedCopy = false;
+		if(packet->getTag() == GD::INTERTECHNO)
+		{
+			auto receivedPacket = std::dynamic_pointer_cast<MyPacket>(packet);
+			if(!receivedPacket) return false;
+			if(receivedPacket->isValid())
+			{
+				if(isRepeat(senderId, receivedPacket->getFrameKey())) return false;
+				combinedCopy = isCombinedCopy(senderId, receivedPacket->getFrameKey(), receivedPacket->getRssi());
+			}
+			peer = resolvePeer(senderId, receivedPacket, !combinedCopy);
+			if(peer) peer->getLinkQuality().addSample(senderId, receivedPacket->getRssi(), BaseLib::HelperFunctions::getTime());
+		}
+		else if(packet->getTag() == GD::CULTX)
+		{
+			auto receivedPacket = std::dynamic_pointer_cast<MyCulTxPacket>(packet);
+			if(!receivedPacket) return false;
+			if(receivedPacket->isValid())
+			{
+				if(isRepeat(senderId, receivedPacket->getFrameKey())) return false;
+				combinedCopy = isCombinedCopy(senderId, receivedPacket->getFrameKey(), receivedPacket->getRssi());
+			}
+			peer = resolvePeer(senderId, receivedPacket, !combinedCopy);
+			if(peer) peer->getLinkQuality().addSample(senderId, receivedPacket->getRssi(), BaseLib::HelperFunctions::getTime());
+		}
+		if(!peer || combinedCopy) return false;
+
+		if(_receiveQueues.empty()) return deliverPacket(peer, packet);
+
+		//All packets of one peer go to the same queue, so they are processed in the order they were received.
+		PacketQueue::Entry entry;
+		entry.senderId = senderId;
+		entry.peer = peer;
+		entry.packet = packet;
+		return _receiveQueues.at(peer->getID() % _receiveQueues.size())->push(entry);
+	}
+	catch(const std::exception& ex)
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+	return false;
+}
+
+bool MyCentral::isRepeat(const std::string& senderId, uint64_t frameKey)
+{
+	auto repeatFilterIterator = _repeatFilters.find(senderId);
+	if(repeatFilterIterator == _repeatFilters.end()) return false;
+	if(!repeatFilterIterator->second->isRepeat(frameKey)) return false;
+	if(GD::bl->debugLevel >= 5) _bl->out.printDebug("Debug: Suppressed repeated frame 0x" + BaseLib::HelperFunctions::getHexString((int32_t)(frameKey >> 32), 8) + BaseLib::HelperFunctions::getHexString((int32_t)frameKey, 8) + " on interface " + senderId + ".");
+	return true;
+}
+
+bool MyCentral::isCombinedCopy(const std::string& senderId, uint64_t frameKey, uint8_t rssi)
+{
+	if(!_frameCombiner || !_frameCombiner->isCopy(frameKey, senderId, rssi)) return false;
+	if(GD::bl->debugLevel >= 5)
+	{
+		FrameCombiner::FrameInfo frameInfo;
+		if(_frameCombiner->getFrameInfo(frameKey, frameInfo))
+		{
+			std::string receivers;
+			for(auto& receiver : frameInfo.receivers)
+			{
+				if(!receivers.empty()) receivers.append(", ");
+				receivers.append(receiver);
+			}
+			_bl->out.printDebug("Debug: Combined copy of frame received by " + senderId + ". Receivers: " + receivers + ". Best RSSI: " + std::to_string(((int32_t)frameInfo.bestRssi) * -1) + " dBm (" + frameInfo.bestInterfaceId + ").");
+		}
+	}
+	return true;
+}
+
+void MyCentral::dispatchThread(int32_t index)
+{
+	std::shared_ptr<PacketQueue> receiveQueue = _receiveQueues.at(index);
+	PacketQueue::Entry entry;
+	while(receiveQueue->pop(entry))
+	{
+		try
+		{
+			if(_disposing) continue;
+			deliverPacket(std::static_pointer_cast<MyPeer>(entry.peer), entry.packet);
+			entry.peer.reset();
+			entry.packet.reset();
+		}
+		catch(const std::exception& ex)
+		{
+			GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+		}
+	}
+}
+
+bool MyCentral::deliverPacket(const PMyPeer& peer, const std::shared_ptr<BaseLib::Systems::Packet>& packet)
+{
+	if(packet->getTag() == GD::INTERTECHNO)
+	{
+		auto receivedPacket = std::dynamic_pointer_cast<MyPacket>(packet);
+		if(!receivedPacket) return false;
+		peer->packetReceived(receivedPacket);
+		return true;
+	}
+
+	if(packet->getTag() == GD::CULTX)
+	{
+		auto receivedPacket = std::dynamic_pointer_cast<MyCulTxPacket>(packet);
+		if(!receivedPacket) return false;
+		peer->packetReceived(receivedPacket);
+		return true;
+	}
+
+	return false;
+}
+
+void MyCentral::valueDirty(uint64_t peerId, bool newValue)
+{
+	bool notify = false;
+	{
+		std::lock_guard<std::mutex> dirtyPeersGuard(_dirtyPeersMutex);
+		_dirtyPeers.insert(peerId);
+		if(newValue)
+		{
+			_pendingValues++;
+			notify = _pendingValues >= _writeBehindThreshold;
+		}
+		else _writeBehindStatistics.coalesced++;
+	}
+	if(notify) _dirtyPeersConditionVariable.notify_one();
+}
+
+void MyCentral::writeBehindThread()
+{
+	while(true)
+	{
+		try
+		{
+			{
+				std::unique_lock<std::mutex> dirtyPeersGuard(_dirtyPeersMutex);
+				_dirtyPeersConditionVariable.wait_for(dirtyPeersGuard, std::chrono::milliseconds(_writeBehindInterval), [&] { return _stopWriteBehindThread || _pendingValues >= _writeBehindThreshold; });
+				if(_stopWriteBehindThread) return;
+			}
+			flushDirtyValues();
+		}
+		catch(const std::exception& ex)
+		{
+			GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+		}
+	}
+}
+
+void MyCentral::flushDirtyValues()
+{
+	try
+	{
+		std::unordered_set<uint64_t> dirtyPeers;
+		{
+			std::lock_guard<std::mutex> dirtyPeersGuard(_dirtyPeersMutex);
+			dirtyPeers.swap(_dirtyPeers);
+			_pendingValues = 0;
+		}
+		if(dirtyPeers.empty()) return;
+
+		auto startTime = std::chrono::steady_clock::now();
+		uint32_t written = 0;
+		for(auto peerId : dirtyPeers)
+		{
+			//Look up in the snapshot directly. A peer with dirty values is materialized already, getPeer() would only add the
+			//materialization check. Every peer is released before the next one, so deletePeer() isn't blocked by the flush.
+			PMyPeer peer;
+			{
+				PPeerSnapshot snapshot = getPeerSnapshot();
+				auto peerIterator = snapshot->peersById.find(peerId);
+				if(peerIterator != snapshot->peersById.end()) peer = peerIterator->second;
+			}
+			if(peer) written += peer->saveDirtyValues();
+		}
+		int64_t flushTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+
+		std::lock_guard<std::mutex> dirtyPeersGuard(_dirtyPeersMutex);
+		_writeBehindStatistics.flushes++;
+		_writeBehindStatistics.written += written;
+		_writeBehindStatistics.lastBatchSize = written;
+		if(written > _writeBehindStatistics.maxBatchSize) _writeBehindStatistics.maxBatchSize = written;
+		_writeBehindStatistics.totalFlushTime += flushTime;
+		if(flushTime > _writeBehindStatistics.maxFlushTime) _writeBehindStatistics.maxFlushTime = flushTime;
+	}
+	catch(const std::exception& ex)
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+}
+
+bool MyCentral::queueEvent(uint64_t peerId, int32_t channel, const std::string& valueKey, const BaseLib::PVariable& value)
+{
+	if(!_eventBatcher || _eventBatchingExcludedKeys.find(valueKey) != _eventBatchingExcludedKeys.end()) return false;
+	_eventBatcher->add(peerId, channel, valueKey, value);
+	return true;
+}
+
+BaseLib::PVariable MyCentral::setScene(const BaseLib::PRpcClientInfo& clientInfo, const BaseLib::PArray& parameters)
+{
+	try
+	{
+		if(parameters->empty() || parameters->size() > 2) return Variable::createError(-1, "Wrong parameter count.");
+		if(parameters->at(0)->type != BaseLib::VariableType::tArray) return Variable::createError(-1, "Parameter 1 is not of type array.");
+		if(parameters->size() == 2 && parameters->at(1)->type != BaseLib::VariableType::tBoolean) return Variable::createError(-1, "Parameter 2 is not of type boolean.");
+		bool wait = parameters->size() == 2 ? parameters->at(1)->booleanValue : true;
+
+		//{{{ Parse targets. A later target for the same peer, channel and key replaces an earlier one.
+		std::vector<SceneTarget> targets;
+		targets.reserve(parameters->at(0)->arrayValue->size());
+		std::map<std::tuple<uint64_t, uint32_t, bool>, size_t> targetIndexes;
+		for(size_t i = 0; i < parameters->at(0)->arrayValue->size(); i++)
+		{
+			const PVariable& element = parameters->at(0)->arrayValue->at(i);
+			std::string targetName = "Target " + std::to_string(i + 1);
+			if(element->type != BaseLib::VariableType::tStruct) return Variable::createError(-1, targetName + " is not of type struct.");
+			auto peerIdIterator = element->structValue->find("peerId");
+			auto channelIterator = element->structValue->find("channel");
+			auto valueIterator = element->structValue->find("value");
+			auto keyIterator = element->structValue->find("key");
+			if(peerIdIterator == element->structValue->end() || channelIterator == element->structValue->end() || valueIterator == element->structValue->end()) return Variable::createError(-1, targetName + " needs the entries \"peerId\", \"channel\" and \"value\".");
+			std::string valueKey = keyIterator == element->structValue->end() ? "STATE" : keyIterator->second->stringValue;
+			if(valueKey != "STATE" && valueKey != "GROUP_STATE") return Variable::createError(-5, targetName + ": Only STATE and GROUP_STATE are supported.");
+
+			SceneTarget target;
+			target.peer = getPeer((uint64_t)peerIdIterator->second->integerValue64);
+			if(!target.peer) return Variable::createError(-2, targetName + ": Unknown peer.");
+			target.channel = channelIterator->second->integerValue;
+			target.group = valueKey == "GROUP_STATE";
+			if(valueIterator->second->type == BaseLib::VariableType::tBoolean) target.value = valueIterator->second->booleanValue;
+			else if(valueIterator->second->type == BaseLib::VariableType::tInteger) target.value = valueIterator->second->integerValue != 0;
+			else if(valueIterator->second->type == BaseLib::VariableType::tInteger64) target.value = valueIterator->second->integerValue64 != 0;
+			else return Variable::createError(-1, targetName + ": \"value\" is not of type boolean or integer.");
+			//All targets are validated before the first packet is queued, so an invalid target doesn't leave the scene partly applied.
+			if(!target.peer->canSetState(target.channel, target.group)) return Variable::createError(-2, targetName + ": Unknown channel.");
+
+			auto result = targetIndexes.emplace(std::make_tuple(target.peer->getID(), target.channel, target.group), targets.size());
+			if(result.second) targets.push_back(std::move(target));
+			else targets.at(result.first->second) = std::move(target);
+		}
+		//}}}
+
+		//GROUP_STATE packets are sent first, so they don't override the STATE targets of the same peer.
+		std::vector<SceneTarget> schedule;
+		schedule.reserve(targets.size());
+		for(auto& target : targets)
+		{
+			if(target.group) schedule.push_back(target);
+		}
+		for(auto& target : targets)
+		{
+			if(!target.group) schedule.push_back(target);
+		}
+
+		std::set<std::tuple<uint64_t, bool, bool>> sentPackets; //Peer ID, GROUP_STATE, value
+		std::vector<std::shared_future<bool>> sentFutures;
+		sentFutures.reserve(schedule.size());
+		uint32_t groupPackets = 0;
+		std::string notSet;
+		for(auto& target : schedule)
+		{
+			if(!sentPackets.emplace(target.peer->getID(), target.group, target.value).second) target.send = false;
+
+			std::shared_future<bool> sent;
+			PVariable result = target.peer->setState(clientInfo, target.channel, target.group, target.value, target.send, sent);
+			if(result->errorStruct)
+			{
+				GD::out.printWarning("Warning: Could not set " + std::string(target.group ? "GROUP_STATE" : "STATE") + " of peer " + std::to_string(target.peer->getID()) + ": " + result->structValue->at("faultString")->stringValue);
+				notSet += (notSet.empty() ? "" : ", ") + std::to_string(target.peer->getID()) + ":" + std::to_string(target.channel);
+				continue;
+			}
+			if(!sent.valid()) continue;
+			sentFutures.push_back(sent);
+			if(target.group) groupPackets++;
+		}
+
+		//The remaining targets are set anyway, as the packets already queued can't be taken back.
+		if(!notSet.empty()) return Variable::createError(-32500, "Could not set the values of the following peers and channels: " + notSet + ". All other targets were set. See log for more details.");
+
+		if(wait)
+		{
+			uint32_t failed = 0;
+			std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+			for(auto& sent : sentFutures)
+			{
+				if(sent.wait_until(deadline) != std::future_status::ready) return Variable::createError(-32500, "Timeout waiting for the packets to be sent.");
+				if(!sent.get()) failed++;
+			}
+			if(failed > 0) return Variable::createError(-32500, std::to_string(failed) + " of " + std::to_string(sentFutures.size()) + " packets could not be sent.");
+		}
+
+		PVariable result = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+		result->structValue->emplace("targets", std::make_shared<BaseLib::Variable>((uint32_t)targets.size()));
+		result->structValue->emplace("packets", std::make_shared<BaseLib::Variable>((uint32_t)sentFutures.size()));
+		result->structValue->emplace("groupPackets", std::make_shared<BaseLib::Variable>(groupPackets));
+		return result;
+	}
+	catch(const std::exception& ex)
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+	return Variable::createError(-32500, "Unknown application error.");
+}
+
+std::shared_ptr<IIntertechnoInterface> MyCentral::selectTxInterface(const std::shared_ptr<IIntertechnoInterface>& assignedInterface, LinkQuality& linkQuality, const std::shared_ptr<BaseLib::Systems::Packet>& packet, IIntertechnoInterface::TxPriority priority, uint64_t coalescingKey)
+{
+	try
+	{
+		if(!_txInterfaceSelection) return assignedInterface;
+		_txInterfaceSelectionStatistics.selected++;
+
+		std::vector<std::shared_ptr<IIntertechnoInterface>> candidates;
+		candidates.reserve(GD::physicalInterfaces.size());
+		if(assignedInterface) candidates.push_back(assignedInterface);
+		int64_t time = BaseLib::HelperFunctions::getTime();
+		std::vector<LinkQuality::Receiver> receivers = linkQuality.getReceivers();
+		for(auto& receiver : receivers)
+		{
+			if(time - receiver.lastSeen > _linkQualityMaxAge) continue;
+			auto interfaceIterator = GD::physicalInterfaces.find(receiver.interfaceId);
+			if(interfaceIterator == GD::physicalInterfaces.end() || !interfaceIterator->second) continue;
+			if(std::find(candidates.begin(), candidates.end(), interfaceIterator->second) == candidates.end()) candidates.push_back(interfaceIterator->second);
+		}
+		for(auto& interface : GD::physicalInterfaces)
+		{
+			if(!interface.second) continue;
+			if(std::find(candidates.begin(), candidates.end(), interface.second) == candidates.end()) candidates.push_back(interface.second);
+		}
+
+		if(coalescingKey != 0)
+		{
+			for(auto& candidate : candidates)
+			{
+				if(candidate->isQueued(coalescingKey)) return candidate;
+			}
+		}
+
+		std::shared_ptr<IIntertechnoInterface> selectedInterface;
+		uint32_t selectedQueueSize = 0;
+		for(auto& candidate : candidates)
+		{
+			if(!candidate->canSend(packet, priority)) continue;
+			uint32_t queueSize = candidate->getTxQueueSize();
+			if(!selectedInterface || queueSize < selectedQueueSize)
+			{
+				selectedInterface = candidate;
+				selectedQueueSize = queueSize;
+				if(queueSize == 0) break;
+			}
+		}
+
+		if(!selectedInterface)
+		{
+			//Let the assigned interface queue or reject the packet as without selection.
+			_txInterfaceSelectionStatistics.unavailable++;
+			return assignedInterface;
+		}
+		if(selectedInterface != assignedInterface)
+		{
+			_txInterfaceSelectionStatistics.switched++;
+			if(_bl->debugLevel >= 5) GD::out.printDebug("Debug: Sending packet using interface " + selectedInterface->getID() + " instead of " + (assignedInterface ? assignedInterface->getID() : std::string("none")) + ".");
+		}
+		return selectedInterface;
+	}
+	catch(const std::exception& ex)
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+	return assignedInterface;
+}
+
+void MyCentral::eventBatchThread()
+{
+	while(true)
+	{
+		try
+		{
+			{
+				std::unique_lock<std::mutex> eventBatchThreadGuard(_eventBatchThreadMutex);
+				_eventBatchThreadConditionVariable.wait_for(eventBatchThreadGuard, std::chrono::milliseconds(_eventBatchingWindow), [&] { return _stopEventBatchThread; });
+				if(_stopEventBatchThread) return;
+			}
+			publishBatchedEvents();
+		}
+		catch(const std::exception& ex)
+		{
+			GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+		}
+	}
+}
+
+void MyCentral::publishBatchedEvents()
+{
+	try
+	{
+		std::vector<EventBatcher::Event> events = _eventBatcher->collect();
+		for(auto& event : events)
+		{
+			PMyPeer peer = getPeer(event.peerId);
+			if(peer) peer->raiseValueEvents(event.channel, event.valueKeys, event.values);
+		}
+	}
+	catch(const std::exception& ex)
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+}
+
+BaseLib::PVariable MyCentral::getStatistics(const BaseLib::PRpcClientInfo& clientInfo, const BaseLib::PArray& parameters)
+{
+	try
+	{
+		PVariable statistics = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+
+		//{{{ Peers
+		PVariable peers = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+		{
+			PPeerSnapshot snapshot = getPeerSnapshot();
+			int32_t materializedPeers = 0;
+			for(auto& peer : snapshot->peersById)
+			{
+				if(peer.second->isMaterialized()) materializedPeers++;
+			}
+			peers->structValue->emplace("count", std::make_shared<BaseLib::Variable>((int32_t)snapshot->peersById.size()));
+			peers->structValue->emplace("materialized", std::make_shared<BaseLib::Variable>(materializedPeers));
+			peers->structValue->emplace("generation", std::make_shared<BaseLib::Variable>((int64_t)_peerGeneration));
+		}
+		statistics->structValue->emplace("peers", peers);
+		//}}}
+
+		//{{{ Receive queue
+		PVariable receiveQueue = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+		receiveQueue->structValue->emplace("enabled", std::make_shared<BaseLib::Variable>(!_receiveQueues.empty()));
+		if(!_receiveQueues.empty())
+		{
+			//Totals over all queues. maxDepth and maxWaitTime are the maxima of the individual queues.
+			PacketQueue::Statistics totals;
+			PVariable queues = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+			for(uint32_t i = 0; i < _receiveQueues.size(); i++)
+			{
+				PacketQueue::Statistics queueStatistics = _receiveQueues.at(i)->getStatistics();
+				totals.capacity += queueStatistics.capacity;
+				totals.depth += queueStatistics.depth;
+				if(queueStatistics.maxDepth > totals.maxDepth) totals.maxDepth = queueStatistics.maxDepth;
+				totals.enqueued += queueStatistics.enqueued;
+				totals.processed += queueStatistics.processed;
+				totals.dropped += queueStatistics.dropped;
+				totals.totalWaitTime += queueStatistics.totalWaitTime;
+				if(queueStatistics.maxWaitTime > totals.maxWaitTime) totals.maxWaitTime = queueStatistics.maxWaitTime;
+
+				PVariable queue = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+				queue->structValue->emplace("depth", std::make_shared<BaseLib::Variable>(queueStatistics.depth));
+				queue->structValue->emplace("maxDepth", std::make_shared<BaseLib::Variable>(queueStatistics.maxDepth));
+				queue->structValue->emplace("processed", std::make_shared<BaseLib::Variable>(queueStatistics.processed));
+				queue->structValue->emplace("dropped", std::make_shared<BaseLib::Variable>(queueStatistics.dropped));
+				queues->structValue->emplace(std::to_string(i), queue);
+			}
+
+			receiveQueue->structValue->emplace("dispatchThreads", std::make_shared<BaseLib::Variable>((int32_t)_dispatchThreads.size()));
+			receiveQueue->structValue->emplace("capacity", std::make_shared<BaseLib::Variable>(totals.capacity));
+			receiveQueue->structValue->emplace("depth", std::make_shared<BaseLib::Variable>(totals.depth));
+			receiveQueue->structValue->emplace("maxDepth", std::make_shared<BaseLib::Variable>(totals.maxDepth));
+			receiveQueue->structValue->emplace("enqueued", std::make_shared<BaseLib::Variable>(totals.enqueued));
+			receiveQueue->structValue->emplace("processed", std::make_shared<BaseLib::Variable>(totals.processed));
+			receiveQueue->structValue->emplace("dropped", std::make_shared<BaseLib::Variable>(totals.dropped));
+			receiveQueue->structValue->emplace("averageWaitTime", std::make_shared<BaseLib::Variable>(totals.processed > 0 ? (int64_t)(totals.totalWaitTime / totals.processed) : (int64_t)0));
+			receiveQueue->structValue->emplace("maxWaitTime", std::make_shared<BaseLib::Variable>(totals.maxWaitTime));
+			receiveQueue->structValue->emplace("queues", queues);
+		}
+		statistics->structValue->emplace("receiveQueue", receiveQueue);
+		//}}}
+
+		//{{{ Write-behind
+		PVariable writeBehind = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+		writeBehind->structValue->emplace("enabled", std::make_shared<BaseLib::Variable>(writeBehindEnabled()));
+		if(writeBehindEnabled())
+		{
+			WriteBehindStatistics writeBehindStatistics;
+			uint32_t pendingValues = 0;
+			{
+				std::lock_guard<std::mutex> dirtyPeersGuard(_dirtyPeersMutex);
+				writeBehindStatistics = _writeBehindStatistics;
+				pendingValues = _pendingValues;
+			}
+			writeBehind->structValue->emplace("interval", std::make_shared<BaseLib::Variable>(_writeBehindInterval));
+			writeBehind->structValue->emplace("threshold", std::make_shared<BaseLib::Variable>(_writeBehindThreshold));
+			writeBehind->structValue->emplace("pending", std::make_shared<BaseLib::Variable>(pendingValues));
+			writeBehind->structValue->emplace("flushes", std::make_shared<BaseLib::Variable>(writeBehindStatistics.flushes));
+			writeBehind->structValue->emplace("written", std::make_shared<BaseLib::Variable>(writeBehindStatistics.written));
+			writeBehind->structValue->emplace("coalesced", std::make_shared<BaseLib::Variable>(writeBehindStatistics.coalesced));
+			writeBehind->structValue->emplace("lastBatchSize", std::make_shared<BaseLib::Variable>(writeBehindStatistics.lastBatchSize));
+			writeBehind->structValue->emplace("maxBatchSize", std::make_shared<BaseLib::Variable>(writeBehindStatistics.maxBatchSize));
+			writeBehind->structValue->emplace("averageFlushTime", std::make_shared<BaseLib::Variable>(writeBehindStatistics.flushes > 0 ? (int64_t)(writeBehindStatistics.totalFlushTime / writeBehindStatistics.flushes) : (int64_t)0));
+			writeBehind->structValue->emplace("maxFlushTime", std::make_shared<BaseLib::Variable>(writeBehindStatistics.maxFlushTime));
+		}
+		statistics->structValue->emplace("writeBehind", writeBehind);
+		//}}}
+
+		//{{{ Transmit
+		PVariable transmit = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+		for(auto& interface : GD::physicalInterfaces)
+		{
+			IIntertechnoInterface::TxStatistics txStatistics = interface.second->getTxStatistics();
+			PVariable interfaceStatistics = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+			interfaceStatistics->structValue->emplace("queued", std::make_shared<BaseLib::Variable>(txStatistics.queued));
+			if(txStatistics.queued)
+			{
+				interfaceStatistics->structValue->emplace("spacing", std::make_shared<BaseLib::Variable>(txStatistics.spacing));
+				interfaceStatistics->structValue->emplace("queueSize", std::make_shared<BaseLib::Variable>(txStatistics.queueSize));
+				interfaceStatistics->structValue->emplace("maxQueueSize", std::make_shared<BaseLib::Variable>(txStatistics.maxQueueSize));
+				interfaceStatistics->structValue->emplace("sent", std::make_shared<BaseLib::Variable>(txStatistics.sent));
+				interfaceStatistics->structValue->emplace("failed", std::make_shared<BaseLib::Variable>(txStatistics.failed));
+				interfaceStatistics->structValue->emplace("dropped", std::make_shared<BaseLib::Variable>(txStatistics.dropped));
+				interfaceStatistics->structValue->emplace("coalesced", std::make_shared<BaseLib::Variable>(txStatistics.coalesced));
+				interfaceStatistics->structValue->emplace("deferred", std::make_shared<BaseLib::Variable>(txStatistics.deferred));
+				interfaceStatistics->structValue->emplace("rerouted", std::make_shared<BaseLib::Variable>(txStatistics.rerouted));
+			}
+			interfaceStatistics->structValue->emplace("dutyCycleExceeded", std::make_shared<BaseLib::Variable>(txStatistics.dutyCycleExceeded));
+			interfaceStatistics->structValue->emplace("airtimeBudget", std::make_shared<BaseLib::Variable>(txStatistics.airtimeBudget));
+			interfaceStatistics->structValue->emplace("airtimeUsed", std::make_shared<BaseLib::Variable>(txStatistics.airtimeUsed));
+			if(txStatistics.writes > 0)
+			{
+				interfaceStatistics->structValue->emplace("writes", std::make_shared<BaseLib::Variable>(txStatistics.writes));
+				interfaceStatistics->structValue->emplace("bytesWritten", std::make_shared<BaseLib::Variable>(txStatistics.bytesWritten));
+				interfaceStatistics->structValue->emplace("bytesPerWrite", std::make_shared<BaseLib::Variable>((int64_t)(txStatistics.bytesWritten / txStatistics.writes)));
+			}
+			transmit->structValue->emplace(interface.first, interfaceStatistics);
+		}
+		statistics->structValue->emplace("transmit", transmit);
+
+		PVariable txInterfaceSelection = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+		txInterfaceSelection->structValue->emplace("enabled", std::make_shared<BaseLib::Variable>(_txInterfaceSelection));
+		if(_txInterfaceSelection)
+		{
+			txInterfaceSelection->structValue->emplace("selected", std::make_shared<BaseLib::Variable>((uint64_t)_txInterfaceSelectionStatistics.selected));
+			txInterfaceSelection->structValue->emplace("switched", std::make_shared<BaseLib::Variable>((uint64_t)_txInterfaceSelectionStatistics.switched));
+			txInterfaceSelection->structValue->emplace("unavailable", std::make_shared<BaseLib::Variable>((uint64_t)_txInterfaceSelectionStatistics.unavailable));
+		}
+		statistics->structValue->emplace("txInterfaceSelection", txInterfaceSelection);
+		//}}}
 
-		for(std::map<std::string, std::shared_ptr<IIntertechnoInterface>>::iterator i = GD::physicalInterfaces.begin(); i != GD::physicalInterfaces.end(); ++i)
+		//{{{ Event batching
+		PVariable eventBatching = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+		eventBatching->structValue->emplace("enabled", std::make_shared<BaseLib::Variable>(eventBatchingEnabled()));
+		if(eventBatchingEnabled())
 		{
-			_physicalInterfaceEventhandlers[i->first] = i->second->addEventHandler((BaseLib::Systems::IPhysicalInterface::IPhysicalInterfaceEventSink*)this);
+			EventBatcher::Statistics eventBatcherStatistics = _eventBatcher->getStatistics();
+			eventBatching->structValue->emplace("window", std::make_shared<BaseLib::Variable>(_eventBatchingWindow));
+			eventBatching->structValue->emplace("updates", std::make_shared<BaseLib::Variable>(eventBatcherStatistics.updates));
+			eventBatching->structValue->emplace("coalesced", std::make_shared<BaseLib::Variable>(eventBatcherStatistics.coalesced));
+			eventBatching->structValue->emplace("batches", std::make_shared<BaseLib::Variable>(eventBatcherStatistics.batches));
+			eventBatching->structValue->emplace("events", std::make_shared<BaseLib::Variable>(eventBatcherStatistics.events));
+			eventBatching->structValue->emplace("maxBatchSize", std::make_shared<BaseLib::Variable>(eventBatcherStatistics.maxBatchSize));
+		}
+		statistics->structValue->emplace("eventBatching", eventBatching);
+		//}}}
+
+		//{{{ Repeat suppression
+		PVariable repeatSuppression = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+		for(auto& repeatFilter : _repeatFilters)
+		{
+			RepeatFilter::Statistics filterStatistics = repeatFilter.second->getStatistics();
+			PVariable interface = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+			interface->structValue->emplace("window", std::make_shared<BaseLib::Variable>(filterStatistics.window));
+			interface->structValue->emplace("passed", std::make_shared<BaseLib::Variable>(filterStatistics.passed));
+			interface->structValue->emplace("suppressed", std::make_shared<BaseLib::Variable>(filterStatistics.suppressed));
+			repeatSuppression->structValue->emplace(repeatFilter.first, interface);
+		}
+		statistics->structValue->emplace("repeatSuppression", repeatSuppression);
+		//}}}
+
+		//{{{ Combining
+		PVariable combining = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+		combining->structValue->emplace("enabled", std::make_shared<BaseLib::Variable>((bool)_frameCombiner));
+		if(_frameCombiner)
+		{
+			combining->structValue->emplace("window", std::make_shared<BaseLib::Variable>(_frameCombiner->getWindow()));
+			combining->structValue->emplace("combined", std::make_shared<BaseLib::Variable>(_frameCombiner->getCombinedFrames()));
+			PVariable interfaces = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+			for(auto& interfaceStatistics : _frameCombiner->getStatistics())
+			{
+				PVariable interface = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+				interface->structValue->emplace("first", std::make_shared<BaseLib::Variable>(interfaceStatistics.second.first));
+				interface->structValue->emplace("copies", std::make_shared<BaseLib::Variable>(interfaceStatistics.second.copies));
+				interface->structValue->emplace("betterCopies", std::make_shared<BaseLib::Variable>(interfaceStatistics.second.betterCopies));
+				interfaces->structValue->emplace(interfaceStatistics.first, interface);
+			}
+			combining->structValue->emplace("interfaces", interfaces);
 		}
+		statistics->structValue->emplace("combining", combining);
+		//}}}
+
+		return statistics;
 	}
 	catch(const std::exception& ex)
 	{
 		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
 	}
+	return Variable::createError(-32500, "Unknown application error.");
 }
 
-void MyCentral::loadPeers()
+void MyCentral::printStatistics(const BaseLib::PVariable& statistics, const std::string& indentation, std::ostringstream& stringStream)
 {
-	try
+	for(auto& element : *statistics->structValue)
 	{
-		std::shared_ptr<BaseLib::Database::DataTable> rows = _bl->db->getPeers(_deviceId);
-		for(BaseLib::Database::DataTable::iterator row = rows->begin(); row != rows->end(); ++row)
+		stringStream << indentation << element.first << ": ";
+		switch(element.second->type)
 		{
-			int32_t peerID = row->second.at(0)->intValue;
-			GD::out.printMessage("Loading Intertechno peer " + std::to_string(peerID));
-			std::shared_ptr<MyPeer> peer(new MyPeer(peerID, row->second.at(2)->intValue, row->second.at(3)->textValue, _deviceId, this));
-			if(!peer->load(this)) continue;
-			if(!peer->getRpcDevice()) continue;
-			std::lock_guard<std::mutex> peersGuard(_peersMutex);
-			if(!peer->getSerialNumber().empty()) _peersBySerial[peer->getSerialNumber()] = peer;
-			_peersById[peerID] = peer;
-			_peers[peer->getAddress()] = peer;
+		case BaseLib::VariableType::tStruct:
+			stringStream << std::endl;
+			printStatistics(element.second, indentation + "  ", stringStream);
+			continue;
+		case BaseLib::VariableType::tBoolean:
+			stringStream << (element.second->booleanValue ? "true" : "false");
+			break;
+		case BaseLib::VariableType::tInteger:
+			stringStream << element.second->integerValue;
+			break;
+		case BaseLib::VariableType::tInteger64:
+			stringStream << element.second->integerValue64;
+			break;
+		case BaseLib::VariableType::tFloat:
+			stringStream << element.second->floatValue;
+			break;
+		case BaseLib::VariableType::tString:
+			stringStream << element.second->stringValue;
+			break;
+		default:
+			break;
 		}
+		stringStream << std::endl;
 	}
-	catch(const std::exception& ex)
-    {
-    	GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
-    }
 }
 
-std::shared_ptr<MyPeer> MyCentral::getPeer(uint64_t id)
+bool MyCentral::processPacket(const std::string& senderId, std::shared_ptr<MyCulTxPacket> myPacket)
 {
-	try
+	PMyPeer peer = resolvePeer(senderId, myPacket);
+	if(!peer) return false;
+	peer->packetReceived(myPacket);
+	return true;
+}
+
+bool MyCentral::processPacket(const std::string& senderId, std::shared_ptr<MyPacket> myPacket)
+{
+	PMyPeer peer = resolvePeer(senderId, myPacket);
+	if(!peer) return false;
+	peer->packetReceived(myPacket);
+	return true;
+}
+
+void MyCentral::recordUnknownSender(UnknownSenderTable::SenderType type, int32_t senderAddress, const std::array<UnknownSenderTable::Candidate, 3>& candidates, uint8_t rssi)
+{
+	//Only log the first frame of a sender. The candidate addresses can be listed with "unknown" or "getUnknownSenders".
+	if(_unknownSenders.record(type, senderAddress, candidates, rssi, BaseLib::HelperFunctions::getTime()) && GD::bl->debugLevel >= 4)
 	{
-		std::lock_guard<std::mutex> peersGuard(_peersMutex);
-		if(_peersById.find(id) != _peersById.end())
-		{
-			std::shared_ptr<MyPeer> peer(std::dynamic_pointer_cast<MyPeer>(_peersById.at(id)));
-			return peer;
-		}
+		_bl->out.printInfo("Info: Received frame from unknown sender 0x" + BaseLib::HelperFunctions::getHexString(senderAddress, 8) + ". Use the CLI command \"unknown\" or the RPC method \"getUnknownSenders\" to list the addresses to use for device creation.");
 	}
-	catch(const std::exception& ex)
-    {
-        GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
-    }
-    return std::shared_ptr<MyPeer>();
 }
 
-std::shared_ptr<MyPeer> MyCentral::getPeer(int32_t address)
+std::string MyCentral::getSenderTypeString(UnknownSenderTable::SenderType type)
 {
-	try
+	switch(type)
 	{
-		std::lock_guard<std::mutex> peersGuard(_peersMutex);
-		if(_peers.find(address) != _peers.end())
-		{
-			std::shared_ptr<MyPeer> peer(std::dynamic_pointer_cast<MyPeer>(_peers.at(address)));
-			return peer;
-		}
+	case UnknownSenderTable::SenderType::tristate:
+		return "tristate";
+	case UnknownSenderTable::SenderType::selfLearning:
+		return "selfLearning";
+	case UnknownSenderTable::SenderType::cultx:
+		return "cultx";
 	}
-	catch(const std::exception& ex)
-    {
-        GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
-    }
-    return std::shared_ptr<MyPeer>();
+	return "";
 }
 
-std::shared_ptr<MyPeer> MyCentral::getPeer(std::string serialNumber)
+BaseLib::PVariable MyCentral::getUnknownSenders(const BaseLib::PRpcClientInfo& clientInfo, const BaseLib::PArray& parameters)
 {
 	try
 	{
-		std::lock_guard<std::mutex> peersGuard(_peersMutex);
-		if(_peersBySerial.find(serialNumber) != _peersBySerial.end())
+		PVariable unknownSenders = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tArray);
+		std::vector<UnknownSenderTable::Entry> entries = _unknownSenders.getEntries();
+		unknownSenders->arrayValue->reserve(entries.size());
+		for(auto& entry : entries)
 		{
-			std::shared_ptr<MyPeer> peer(std::dynamic_pointer_cast<MyPeer>(_peersBySerial.at(serialNumber)));
-			return peer;
+			PVariable unknownSender = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+			unknownSender->structValue->emplace("type", std::make_shared<BaseLib::Variable>(getSenderTypeString(entry.type)));
+			unknownSender->structValue->emplace("senderAddress", std::make_shared<BaseLib::Variable>(entry.senderAddress));
+			unknownSender->structValue->emplace("count", std::make_shared<BaseLib::Variable>(entry.count));
+			unknownSender->structValue->emplace("firstSeen", std::make_shared<BaseLib::Variable>(entry.firstSeen / 1000));
+			unknownSender->structValue->emplace("lastSeen", std::make_shared<BaseLib::Variable>(entry.lastSeen / 1000));
+			unknownSender->structValue->emplace("bestRssi", std::make_shared<BaseLib::Variable>(((int32_t)entry.bestRssi) * -1));
+			PVariable candidates = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tArray);
+			for(auto& candidate : entry.candidates)
+			{
+				if(candidate.deviceType == -1) continue;
+				PVariable element = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+				element->structValue->emplace("deviceType", std::make_shared<BaseLib::Variable>(candidate.deviceType));
+				element->structValue->emplace("address", std::make_shared<BaseLib::Variable>(candidate.address));
+				candidates->arrayValue->push_back(element);
+			}
+			unknownSender->structValue->emplace("candidates", candidates);
+			unknownSenders->arrayValue->push_back(unknownSender);
 		}
+		return unknownSenders;
 	}
 	catch(const std::exception& ex)
-    {
-        GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
-    }
-    return std::shared_ptr<MyPeer>();
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+	return Variable::createError(-32500, "Unknown application error.");
 }
 
-std::pair<int32_t, int32_t> MyCentral::getOldItGroupStartCodeAndChannel(int32_t address)
+BaseLib::PVariable MyCentral::getDutyCycle(const BaseLib::PRpcClientInfo& clientInfo, const BaseLib::PArray& parameters)
 {
-	std::pair<int32_t, int32_t> returnValue(0, 0);
 	try
 	{
-		int32_t groupCode = (address & 0x3C) >> 2;
-		int32_t groupStartCode = 0;
-		int32_t channel = 0;
-		switch(groupCode)
+		PVariable dutyCycle = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+		for(auto& interface : GD::physicalInterfaces)
 		{
-		case 0:
-			channel = 1;
-			groupStartCode = 0;
-			break;
-		case 8:
-			channel = 2;
-			groupStartCode = 0;
-			break;
-		case 4:
-			channel = 3;
-			groupStartCode = 0;
-			break;
-		case 12:
-			channel = 4;
-			groupStartCode = 0;
-			break;
-		case 2:
-			channel = 1;
-			groupStartCode = 2;
-			break;
-		case 10:
-			channel = 2;
-			groupStartCode = 2;
-			break;
-		case 6:
-			channel = 3;
-			groupStartCode = 2;
-			break;
-		case 14:
-			channel = 4;
-			groupStartCode = 2;
-			break;
-		case 1:
-			channel = 1;
-			groupStartCode = 1;
-			break;
-		case 9:
-			channel = 2;
-			groupStartCode = 1;
-			break;
-		case 5:
-			channel = 3;
-			groupStartCode = 1;
-			break;
-		case 13:
-			channel = 4;
-			groupStartCode = 1;
-			break;
-		case 3:
-			channel = 1;
-			groupStartCode = 3;
-			break;
-		case 11:
-			channel = 2;
-			groupStartCode = 3;
-			break;
-		case 7:
-			channel = 3;
-			groupStartCode = 3;
-			break;
-		case 15:
-			channel = 4;
-			groupStartCode = 3;
-			break;
-		default:
-			channel = 0;
+			IIntertechnoInterface::TxStatistics txStatistics = interface.second->getTxStatistics();
+			int64_t remaining = std::max(txStatistics.airtimeBudget - txStatistics.airtimeUsed, (int64_t)0);
+			PVariable element = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+			element->structValue->emplace("budget", std::make_shared<BaseLib::Variable>(txStatistics.airtimeBudget));
+			element->structValue->emplace("used", std::make_shared<BaseLib::Variable>(txStatistics.airtimeUsed));
+			element->structValue->emplace("remaining", std::make_shared<BaseLib::Variable>(remaining));
+			element->structValue->emplace("remainingPercent", std::make_shared<BaseLib::Variable>(txStatistics.airtimeBudget > 0 ? (double)remaining * 100.0 / (double)txStatistics.airtimeBudget : 0.0));
+			element->structValue->emplace("queueSize", std::make_shared<BaseLib::Variable>(txStatistics.queueSize));
+			element->structValue->emplace("deferred", std::make_shared<BaseLib::Variable>(txStatistics.deferred));
+			element->structValue->emplace("rerouted", std::make_shared<BaseLib::Variable>(txStatistics.rerouted));
+			element->structValue->emplace("limitReached", std::make_shared<BaseLib::Variable>(txStatistics.dutyCycleExceeded));
+			dutyCycle->structValue->emplace(interface.first, element);
 		}
-		returnValue.first = groupStartCode;
-		returnValue.second = channel;
+		return dutyCycle;
 	}
 	catch(const std::exception& ex)
-    {
-        GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
-    }
-    return returnValue;
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+	return Variable::createError(-32500, "Unknown application error.");
 }
 
-
-bool MyCentral::onPacketReceived(std::string& senderId, std::shared_ptr<BaseLib::Systems::Packet> packet)
+BaseLib::PVariable MyCentral::getLinkQuality(const BaseLib::PRpcClientInfo& clientInfo, const BaseLib::PArray& parameters)
 {
-		if(_disposing) return false;
+	try
+	{
+		if(!parameters->empty() && parameters->at(0)->type != BaseLib::VariableType::tInteger && parameters->at(0)->type != BaseLib::VariableType::tInteger64) return Variable::createError(-1, "Parameter 1 is not of type integer.");
 
-		if(packet->getTag() == GD::INTERTECHNO) {
-			auto receivedPacket = std::dynamic_pointer_cast<MyPacket>(packet);
-			if(!receivedPacket) return false;
-			return processPacket(senderId,receivedPacket);
+		std::vector<PMyPeer> peers;
+		PPeerSnapshot snapshot = getPeerSnapshot();
+		if(!parameters->empty())
+		{
+			auto peerIterator = snapshot->peersById.find(parameters->at(0)->integerValue64);
+			if(peerIterator == snapshot->peersById.end()) return Variable::createError(-2, "Unknown peer.");
+			peers.push_back(peerIterator->second);
 		}
-
-		if(packet->getTag() == GD::CULTX) {
-			auto receivedPacket = std::dynamic_pointer_cast<MyCulTxPacket>(packet);
-			if(!receivedPacket) return false;
-			return processPacket(senderId,receivedPacket);
+		else
+		{
+			peers.reserve(snapshot->peersById.size());
+			for(auto& peer : snapshot->peersById)
+			{
+				peers.push_back(peer.second);
+			}
 		}
 
-		return false;
+		int64_t time = BaseLib::HelperFunctions::getTime();
+		PVariable linkQuality = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tArray);
+		linkQuality->arrayValue->reserve(peers.size());
+		for(auto& peer : peers)
+		{
+			std::vector<LinkQuality::Receiver> receivers = peer->getLinkQuality().getReceivers();
+			PVariable element = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+			element->structValue->emplace("peerId", std::make_shared<BaseLib::Variable>((int64_t)peer->getID()));
+			element->structValue->emplace("serialNumber", std::make_shared<BaseLib::Variable>(peer->getSerialNumber()));
+			element->structValue->emplace("interface", std::make_shared<BaseLib::Variable>(peer->getPhysicalInterfaceId()));
+			element->structValue->emplace("bestInterface", std::make_shared<BaseLib::Variable>(peer->getLinkQuality().getBestInterface(time, _linkQualityMaxAge)));
+			PVariable receiverArray = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tArray);
+			for(auto& receiver : receivers)
+			{
+				PVariable receiverStruct = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tStruct);
+				receiverStruct->structValue->emplace("interface", std::make_shared<BaseLib::Variable>(receiver.interfaceId));
+				receiverStruct->structValue->emplace("frames", std::make_shared<BaseLib::Variable>(receiver.frames));
+				receiverStruct->structValue->emplace("framesPerHour", std::make_shared<BaseLib::Variable>(receiver.getFramesPerHour(time)));
+				receiverStruct->structValue->emplace("firstSeen", std::make_shared<BaseLib::Variable>(receiver.firstSeen / 1000));
+				receiverStruct->structValue->emplace("lastSeen", std::make_shared<BaseLib::Variable>(receiver.lastSeen / 1000));
+				if(receiver.rssiSamples > 0)
+				{
+					receiverStruct->structValue->emplace("averageRssi", std::make_shared<BaseLib::Variable>((double)receiver.averageRssi / -16.0));
+					receiverStruct->structValue->emplace("bestRssi", std::make_shared<BaseLib::Variable>(((int32_t)receiver.bestRssi) * -1));
+					receiverStruct->structValue->emplace("worstRssi", std::make_shared<BaseLib::Variable>(((int32_t)receiver.worstRssi) * -1));
+					PVariable histogram = std::make_shared<BaseLib::Variable>(BaseLib::VariableType::tArray);
+					for(auto count : receiver.histogram)
+					{
+						histogram->arrayValue->push_back(std::make_shared<BaseLib::Variable>(count));
+					}
+					receiverStruct->structValue->emplace("histogram", histogram);
+				}
+				receiverArray->arrayValue->push_back(receiverStruct);
+			}
+			element->structValue->emplace("receivers", receiverArray);
+			linkQuality->arrayValue->push_back(element);
+		}
+		return linkQuality;
+	}
+	catch(const std::exception& ex)
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+	return Variable::createError(-32500, "Unknown application error.");
 }
 
-
-bool MyCentral::processPacket(const std::string& senderId, std::shared_ptr<MyCulTxPacket> myPacket)
+PMyPeer MyCentral::resolvePeer(const std::string& senderId, const std::shared_ptr<MyCulTxPacket>& myPacket, bool recordUnknown)
 {
 	try
 	{
 		if(GD::bl->debugLevel >= 4) _bl->out.printDebug(BaseLib::HelperFunctions::getTimeString(myPacket->getTimeReceived()) + " CULTX packet received from " + BaseLib::HelperFunctions::getHexString(myPacket->senderAddress(), 8) + " :" + myPacket->getPayload());
-		std::vector<std::shared_ptr<BaseLib::Systems::Peer>> peers = getPeers();
-		uint8_t processed = 0;
-		for(auto peer : peers)
-		{
-			PMyPeer myPeer = std::dynamic_pointer_cast<MyPeer>(peer);
-			if(senderId != myPeer->getPhysicalInterfaceId()) return false;
-			if(myPeer->getAddress() == myPacket->senderAddress()) {
-				myPeer->packetReceived(myPacket);
-				processed = 1;
-				break;
-			}
+		if(!myPacket->isValid()) return PMyPeer();
+		PMyPeer peer = getPeerSnapshot()->getPeerByDerivedAddress(senderId, 0x50, myPacket->senderAddress(), (bool)_frameCombiner);
+		if(!peer)
+		{
+			std::array<UnknownSenderTable::Candidate, 3> candidates;
+			candidates[0].deviceType = 0x50;
+			candidates[0].address = myPacket->senderAddress();
+			if(recordUnknown) recordUnknownSender(UnknownSenderTable::SenderType::cultx, myPacket->senderAddress(), candidates, myPacket->getRssi());
+			return PMyPeer();
 		}
-		if(processed == 0 && GD::bl->debugLevel >= 4) _bl->out.printInfo(BaseLib::HelperFunctions::getTimeString(myPacket->getTimeReceived()) + " CULTX packet received from " + BaseLib::HelperFunctions::getHexString(myPacket->senderAddress(), 8) + "; Device not yet added to database.");
 
+		return peer;
 	}
 	catch(const std::exception& ex)
     {
@@ -300,115 +1465,125 @@ bool MyCentral::processPacket(const std::string& senderId, std::shared_ptr<MyCul
     {
         GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__);
     }
-    return false;
+    return PMyPeer();
 }
 
-bool MyCentral::processPacket(const std::string& senderId, std::shared_ptr<MyPacket> myPacket)
+PMyPeer MyCentral::resolvePeer(const std::string& senderId, const std::shared_ptr<MyPacket>& myPacket, bool recordUnknown)
 {
 	try
 	{
-
 		if(GD::bl->debugLevel >= 4) _bl->out.printInfo(BaseLib::HelperFunctions::getTimeString(myPacket->getTimeReceived()) + " Intertechno packet received from " + BaseLib::HelperFunctions::getHexString(myPacket->senderAddress(), 8) + " (RSSI: " + std::to_string(((int32_t)myPacket->getRssi()) * -1) + " dBm): " + myPacket->getPayload());
 
-		if(myPacket->getPayload().find('F') != std::string::npos)
+		if(!myPacket->isValid()) return PMyPeer();
+
+		if(myPacket->getCommand().hasFloatingBit())
 		{
-			std::vector<std::shared_ptr<BaseLib::Systems::Peer>> peers = getPeers();
-			for(auto peer : peers)
+			int32_t senderAddress = myPacket->senderAddress();
+			PPeerSnapshot snapshot = getPeerSnapshot();
+
+			PMyPeer peer = snapshot->getPeerByDerivedAddress(senderId, 0x24, senderAddress >> 5, (bool)_frameCombiner); //Elro
+			if(peer)
 			{
-				PMyPeer myPeer = std::dynamic_pointer_cast<MyPeer>(peer);
-				if(senderId != myPeer->getPhysicalInterfaceId()) return false;
-				if(myPeer->getDeviceType() == 0x24) //Elro
-				{
-					if(myPeer->getAddress() == (myPacket->senderAddress() >> 5))
-					{
-						int32_t channel = (~myPacket->senderAddress()) & 0x1F;
-						switch(channel)
-						{
-						case 1:
-							channel = 5;
-							break;
-						case 2:
-							channel = 4;
-							break;
-						case 4:
-							channel = 3;
-							break;
-						case 8:
-							channel = 2;
-							break;
-						case 16:
-							channel = 1;
-							break;
-						default:
-							channel = 0;
-						}
-						myPacket->setChannel(channel);
-						myPeer->packetReceived(myPacket);
-						break;
-					}
-				}
-				else if(myPeer->getDeviceType() == 0x30) //Old Intertechno 1 channel sensor
+				int32_t channel = (~senderAddress) & 0x1F;
+				switch(channel)
 				{
-					if(myPeer->getAddress() == (myPacket->senderAddress() >> 2))
-					{
-						myPacket->setChannel(1);
-						myPeer->packetReceived(myPacket);
-						break;
-					}
+				case 1:
+					channel = 5;
+					break;
+				case 2:
+					channel = 4;
+					break;
+				case 4:
+					channel = 3;
+					break;
+				case 8:
+					channel = 2;
+					break;
+				case 16:
+					channel = 1;
+					break;
+				default:
+					channel = 0;
 				}
-				else if(myPeer->getDeviceType() == 0x33) //Old Intertechno remote
-				{
-					std::pair<int32_t, int32_t> startCodeAndChannel = getOldItGroupStartCodeAndChannel(myPacket->senderAddress());
+				myPacket->setChannel(channel);
+				return peer;
+			}
 
-					if(myPeer->getAddress() == (((myPacket->senderAddress() & 0x3C0) >> 2) | startCodeAndChannel.first))
-					{
-						myPacket->setChannel(startCodeAndChannel.second);
-						myPeer->packetReceived(myPacket);
-						break;
-					}
-				}
-				else
-                {
-				    if(GD::bl->debugLevel >= 4) _bl->out.printInfo(BaseLib::HelperFunctions::getTimeString(myPacket->getTimeReceived()) + " Please use one of the following addresses for device creation: Intertechno multi-channel remote or sensor (use device type 0x33): 0x" + BaseLib::HelperFunctions::getHexString(((myPacket->senderAddress() & 0x3C0) >> 2) | getOldItGroupStartCodeAndChannel(myPacket->senderAddress()).first, 4) + "; Intertechno one channel remote or sensor (use device type 0x30): 0x" + BaseLib::HelperFunctions::getHexString(myPacket->senderAddress() >> 2, 4) + "; Elro (use device type 0x24): 0x" + BaseLib::HelperFunctions::getHexString(myPacket->senderAddress() >> 5, 4));
-                }
+			peer = snapshot->getPeerByDerivedAddress(senderId, 0x30, senderAddress >> 2, (bool)_frameCombiner); //Old Intertechno 1 channel sensor
+			if(peer)
+			{
+				myPacket->setChannel(1);
+				return peer;
+			}
+
+			std::pair<int32_t, int32_t> startCodeAndChannel = getOldItGroupStartCodeAndChannel(senderAddress);
+			peer = snapshot->getPeerByDerivedAddress(senderId, 0x33, ((senderAddress & 0x3C0) >> 2) | startCodeAndChannel.first, (bool)_frameCombiner); //Old Intertechno remote
+			if(peer)
+			{
+				myPacket->setChannel(startCodeAndChannel.second);
+				return peer;
 			}
 
-			if(peers.empty() && GD::bl->debugLevel >= 4) _bl->out.printInfo(BaseLib::HelperFunctions::getTimeString(myPacket->getTimeReceived()) + " Please use one of the following addresses for device creation: Intertechno multi-channel remote or sensor (use device type 0x33): 0x" + BaseLib::HelperFunctions::getHexString(((myPacket->senderAddress() & 0x3C0) >> 2) | getOldItGroupStartCodeAndChannel(myPacket->senderAddress()).first, 4) + "; Intertechno one channel remote or sensor (use device type 0x30): 0x" + BaseLib::HelperFunctions::getHexString(myPacket->senderAddress() >> 2, 4) + "; Elro (use device type 0x24): 0x" + BaseLib::HelperFunctions::getHexString(myPacket->senderAddress() >> 5, 4));
+			std::array<UnknownSenderTable::Candidate, 3> candidates;
+			candidates[0].deviceType = 0x33;
+			candidates[0].address = ((senderAddress & 0x3C0) >> 2) | startCodeAndChannel.first;
+			candidates[1].deviceType = 0x30;
+			candidates[1].address = senderAddress >> 2;
+			candidates[2].deviceType = 0x24;
+			candidates[2].address = senderAddress >> 5;
+			if(recordUnknown) recordUnknownSender(UnknownSenderTable::SenderType::tristate, senderAddress, candidates, myPacket->getRssi());
 		}
 		else
 		{
-			PMyPeer peer = getPeer(myPacket->senderAddress());
-			if(!peer)
+			//Look up in the snapshot directly. getPeer() would materialize the peer on the interface thread.
+			PPeerSnapshot snapshot = getPeerSnapshot();
+			auto peerIterator = snapshot->peersByAddress.find(myPacket->senderAddress());
+			if(peerIterator == snapshot->peersByAddress.end())
 			{
-				peer = getPeer((int32_t)(0x80000000 | myPacket->senderAddress()));
-				if(!peer)
+				peerIterator = snapshot->peersByAddress.find((int32_t)(0x80000000 | myPacket->senderAddress()));
+				if(peerIterator == snapshot->peersByAddress.end())
                 {
-					if(GD::bl->debugLevel >= 4) _bl->out.printInfo(BaseLib::HelperFunctions::getTimeString(myPacket->getTimeReceived()) + " Please use one of the following addresses for device creation (possible device types: 0x10 to 0x1F): 0x" + BaseLib::HelperFunctions::getHexString(myPacket->senderAddress(), 8) + " or 0x" + BaseLib::HelperFunctions::getHexString((int32_t)(0x80000000 | myPacket->senderAddress()), 8));
-                    return false;
+					std::array<UnknownSenderTable::Candidate, 3> candidates;
+					candidates[0].deviceType = 0x10;
+					candidates[0].address = myPacket->senderAddress();
+					candidates[1].deviceType = 0x10;
+					candidates[1].address = (int32_t)(0x80000000 | myPacket->senderAddress());
+					if(recordUnknown) recordUnknownSender(UnknownSenderTable::SenderType::selfLearning, myPacket->senderAddress(), candidates, myPacket->getRssi());
+                    return PMyPeer();
                 }
 			}
-			if(senderId != peer->getPhysicalInterfaceId()) return false;
-
-			peer->packetReceived(myPacket);
+			if(!_frameCombiner && senderId != peerIterator->second->getPhysicalInterfaceId()) return PMyPeer();
+			return peerIterator->second;
 		}
 	}
 	catch(const std::exception& ex)
     {
         GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
     }
-    return false;
+    return PMyPeer();
 }
 
 void MyCentral::savePeers(bool full)
 {
 	try
 	{
-		std::lock_guard<std::mutex> peersGuard(_peersMutex);
-		for(std::map<uint64_t, std::shared_ptr<BaseLib::Systems::Peer>>::iterator i = _peersById.begin(); i != _peersById.end(); ++i)
+		if(writeBehindEnabled()) flushDirtyValues();
+		writePeerStateFile();
+
+		//Only peers changed since the last call are saved. The snapshot is used, so receiving packets is not blocked.
+		PPeerSnapshot snapshot = getPeerSnapshot();
+		std::vector<PMyPeer> dirtyPeers;
+		for(auto& peer : snapshot->peersById)
+		{
+			if(peer.second->resetDirty()) dirtyPeers.push_back(peer.second);
+		}
+		if(dirtyPeers.empty()) return;
+
+		for(auto& peer : dirtyPeers)
 		{
-			GD::out.printInfo("Info: Saving Intertechno peer " + std::to_string(i->second->getID()));
-			i->second->save(full, full, full);
+			peer->save(full, full, full);
 		}
+		GD::out.printInfo("Info: Saved " + std::to_string(dirtyPeers.size()) + " changed Intertechno peers.");
 	}
 	catch(const std::exception& ex)
     {
@@ -448,6 +1623,7 @@ void MyCentral::deletePeer(uint64_t id)
 			peerIterator = _peers.find(peer->getAddress());
 			if(peerIterator != _peers.end() && peerIterator->second->getID() == id) _peers.erase(peerIterator);
 		}
+		unpublishPeer(id);
 
 		int32_t i = 0;
 		while(peer.use_count() > 1 && i < 600)
@@ -483,6 +1659,9 @@ std::string MyCentral::handleCliCommand(std::string command)
 			stringStream << "peers remove (pr)   Remove a peer" << std::endl;
 			stringStream << "peers select (ps)   Select a peer" << std::endl;
 			stringStream << "peers setname (pn)  Name a peer" << std::endl;
+			stringStream << "linkquality (lq)    Prints the link statistics of the peers" << std::endl;
+			stringStream << "statistics (st)     Prints receive and dispatch statistics" << std::endl;
+			stringStream << "unknown (uk)        Lists devices not paired yet" << std::endl;
 			stringStream << "unselect (u)        Unselect this device" << std::endl;
 			return stringStream.str();
 		}
@@ -523,6 +1702,7 @@ std::string MyCentral::handleCliCommand(std::string command)
 					_peers[peer->getAddress()] = peer;
 					_peersById[peer->getID()] = peer;
 					_peersMutex.unlock();
+					publishPeer(peer);
 				}
 				catch(const std::exception& ex)
 				{
@@ -596,7 +1776,8 @@ std::string MyCentral::handleCliCommand(std::string command)
 					 if(filterType == "name") BaseLib::HelperFunctions::toLower(filterValue);
 				}
 
-				if(_peersById.empty())
+				PPeerSnapshot snapshot = getPeerSnapshot();
+				if(snapshot->peersById.empty())
 				{
 					stringStream << "No peers are paired to this central." << std::endl;
 					return stringStream.str();
@@ -629,8 +1810,7 @@ std::string MyCentral::handleCliCommand(std::string command)
 					<< std::setw(typeWidth1) << " " << bar
 					<< std::setw(typeWidth2)
 					<< std::endl;
-				_peersMutex.lock();
-				for(std::map<uint64_t, std::shared_ptr<BaseLib::Systems::Peer>>::iterator i = _peersById.begin(); i != _peersById.end(); ++i)
+				for(auto i = snapshot->peersById.begin(); i != snapshot->peersById.end(); ++i)
 				{
 					if(filterType == "id")
 					{
@@ -686,17 +1866,112 @@ std::string MyCentral::handleCliCommand(std::string command)
 					else stringStream << std::setw(typeWidth2);
 					stringStream << std::endl << std::dec;
 				}
-				_peersMutex.unlock();
 				stringStream << "─────────┴───────────────────────────┴───────────────┴──────────┴──────────┴───────────────────────────────────────────────" << std::endl;
 
 				return stringStream.str();
 			}
 			catch(const std::exception& ex)
 			{
-				_peersMutex.unlock();
 				GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
 			}
 		}
+		else if(BaseLib::HelperFunctions::checkCliCommand(command, "statistics", "st", "", 0, arguments, showHelp))
+		{
+			if(showHelp)
+			{
+				stringStream << "Description: This command prints receive and dispatch statistics." << std::endl;
+				stringStream << "Usage: statistics" << std::endl << std::endl;
+				stringStream << "Parameters:" << std::endl;
+				stringStream << "  There are no parameters." << std::endl;
+				return stringStream.str();
+			}
+
+			PVariable statistics = getStatistics(nullptr, std::make_shared<BaseLib::Array>());
+			if(statistics->errorStruct) return "Error reading statistics. See log file for more details.\n";
+			printStatistics(statistics, "", stringStream);
+			return stringStream.str();
+		}
+		else if(BaseLib::HelperFunctions::checkCliCommand(command, "unknown", "uk", "", 0, arguments, showHelp))
+		{
+			if(showHelp)
+			{
+				stringStream << "Description: This command lists the senders of received frames which are not paired to the central, most frequent first." << std::endl;
+				stringStream << "Usage: unknown [clear]" << std::endl << std::endl;
+				stringStream << "Parameters:" << std::endl;
+				stringStream << "  clear: Removes all entries." << std::endl;
+				return stringStream.str();
+			}
+
+			if(!arguments.empty() && arguments.at(0) == "clear")
+			{
+				_unknownSenders.clear();
+				return "Unknown senders cleared.\n";
+			}
+
+			std::vector<UnknownSenderTable::Entry> entries = _unknownSenders.getEntries();
+			if(entries.empty()) return "No unknown senders.\n";
+
+			stringStream << std::left << std::setfill(' ') << std::setw(13) << "Type" << std::setw(12) << "Sender" << std::setw(9) << "Count" << std::setw(25) << "Last seen" << std::setw(11) << "Best RSSI" << "Candidates (device type: address)" << std::endl;
+			for(auto& entry : entries)
+			{
+				stringStream << std::setw(13) << getSenderTypeString(entry.type) << std::setw(12) << ("0x" + BaseLib::HelperFunctions::getHexString(entry.senderAddress, 8)) << std::setw(9) << entry.count << std::setw(25) << BaseLib::HelperFunctions::getTimeString(entry.lastSeen) << std::setw(11) << (std::to_string(((int32_t)entry.bestRssi) * -1) + " dBm");
+				bool first = true;
+				for(auto& candidate : entry.candidates)
+				{
+					if(candidate.deviceType == -1) continue;
+					if(!first) stringStream << ", ";
+					first = false;
+					stringStream << "0x" << BaseLib::HelperFunctions::getHexString(candidate.deviceType, 2);
+					if(entry.type == UnknownSenderTable::SenderType::selfLearning) stringStream << "-0x1F";
+					stringStream << ": 0x" << BaseLib::HelperFunctions::getHexString(candidate.address, entry.type == UnknownSenderTable::SenderType::tristate ? 4 : 8);
+				}
+				stringStream << std::endl;
+			}
+			return stringStream.str();
+		}
+		else if(BaseLib::HelperFunctions::checkCliCommand(command, "linkquality", "lq", "", 0, arguments, showHelp))
+		{
+			if(showHelp)
+			{
+				stringStream << "Description: This command prints the link statistics of all peers or of one peer for every interface receiving its frames." << std::endl;
+				stringStream << "Usage: linkquality [PEERID]" << std::endl << std::endl;
+				stringStream << "Parameters:" << std::endl;
+				stringStream << "  PEERID: Optional id of the peer to print the statistics for." << std::endl;
+				return stringStream.str();
+			}
+
+			BaseLib::PArray parameters = std::make_shared<BaseLib::Array>();
+			if(!arguments.empty())
+			{
+				uint64_t peerId = BaseLib::Math::getNumber(arguments.at(0), false);
+				if(peerId == 0) return "Invalid id.\n";
+				parameters->push_back(std::make_shared<BaseLib::Variable>((int64_t)peerId));
+			}
+			PVariable linkQuality = getLinkQuality(BaseLib::PRpcClientInfo(), parameters);
+			if(linkQuality->errorStruct) return linkQuality->structValue->at("faultString")->stringValue + "\n";
+
+			stringStream << std::left << std::setfill(' ') << std::setw(8) << "ID" << std::setw(15) << "Interface" << std::setw(10) << "Frames" << std::setw(10) << "Frames/h" << std::setw(10) << "Average" << std::setw(8) << "Best" << std::setw(8) << "Worst" << "Last seen" << std::endl;
+			for(auto& element : *linkQuality->arrayValue)
+			{
+				std::string peerId = std::to_string(element->structValue->at("peerId")->integerValue64);
+				auto& receivers = element->structValue->at("receivers")->arrayValue;
+				if(receivers->empty()) stringStream << std::setw(8) << peerId << "No frames received." << std::endl;
+				for(auto& receiver : *receivers)
+				{
+					auto& receiverStruct = receiver->structValue;
+					bool hasRssi = receiverStruct->find("averageRssi") != receiverStruct->end();
+					std::string averageRssi = hasRssi ? std::to_string((int32_t)std::lround(receiverStruct->at("averageRssi")->floatValue)) : "-";
+					std::string bestRssi = hasRssi ? std::to_string(receiverStruct->at("bestRssi")->integerValue) : "-";
+					std::string worstRssi = hasRssi ? std::to_string(receiverStruct->at("worstRssi")->integerValue) : "-";
+					std::string interfaceId = receiverStruct->at("interface")->stringValue;
+					if(interfaceId == element->structValue->at("bestInterface")->stringValue) interfaceId.append(" *");
+					stringStream << std::setw(8) << peerId << std::setw(15) << interfaceId << std::setw(10) << receiverStruct->at("frames")->integerValue64 << std::setw(10) << receiverStruct->at("framesPerHour")->integerValue << std::setw(10) << averageRssi << std::setw(8) << bestRssi << std::setw(8) << worstRssi << BaseLib::HelperFunctions::getTimeString(receiverStruct->at("lastSeen")->integerValue64 * 1000) << std::endl;
+					peerId.clear();
+				}
+			}
+			stringStream << std::endl << "RSSI values in dBm. * marks the interface with the best average RSSI." << std::endl;
+			return stringStream.str();
+		}
 		else if(command.compare(0, 13, "peers setname") == 0 || command.compare(0, 2, "pn") == 0)
 		{
 			uint64_t peerID = 0;
@@ -741,6 +2016,7 @@ std::string MyCentral::handleCliCommand(std::string command)
 			{
 				std::shared_ptr<MyPeer> peer = getPeer(peerID);
 				peer->setName(name);
+				peer->setDirty();
 				stringStream << "Name set to \"" << name << "\"." << std::endl;
 			}
 			return stringStream.str();
@@ -794,6 +2070,7 @@ PVariable MyCentral::createDevice(BaseLib::PRpcClientInfo clientInfo, int32_t de
 			_peersById[peer->getID()] = peer;
 			_peersBySerial[peer->getSerialNumber()] = peer;
 			_peersMutex.unlock();
+			publishPeer(peer);
 		}
 		catch(const std::exception& ex)
 		{
@@ -869,7 +2146,9 @@ PVariable MyCentral::setInterface(BaseLib::PRpcClientInfo clientInfo, uint64_t p
 	{
 		std::shared_ptr<MyPeer> peer(getPeer(peerId));
 		if(!peer) return Variable::createError(-2, "Unknown device.");
-		return peer->setInterface(clientInfo, interfaceId);
+		PVariable result = peer->setInterface(clientInfo, interfaceId);
+		if(!result->errorStruct) publishPeer(peer); //The address index of the snapshot is per interface
+		return result;
 	}
 	catch(const std::exception& ex)
     {
@@ -34,11 +34,23 @@
 
 #include "MyPeer.h"
 #include "MyPacket.h"
+#include "EventBatcher.h"
+#include "FrameCombiner.h"
+#include "PacketQueue.h"
+#include "PeerStateFile.h"
+#include "RepeatFilter.h"
+#include "UnknownSenderTable.h"
 #include <homegear-base/BaseLib.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include "MyCulTxPacket.h"
 
 namespace MyFamily
@@ -68,16 +80,318 @@ public:
 	virtual PVariable deleteDevice(BaseLib::PRpcClientInfo clientInfo, uint64_t peerId, int32_t flags);
 	virtual PVariable setInterface(BaseLib::PRpcClientInfo clientInfo, uint64_t peerId, std::string interfaceId);
 
+	/**
+	 * Adds the peer to or updates the peer in the peer snapshot used by the receive path. Needs to be called whenever a peer is
+	 * added or its interface changes.
+	 */
+	void publishPeer(const PMyPeer& peer);
+
+	const ChangeDetectionSettings& getChangeDetectionSettings() { return _changeDetectionSettings; }
+
+	/**
+	 * Returns true when changed values are written to the database by the write-behind thread instead of immediately.
+	 */
+	bool writeBehindEnabled() { return _writeBehindInterval > 0; }
+
+	/**
+	 * Returns the maximum time in seconds setValue() waits for the packet to be sent when called with "wait". 0 when setValue()
+	 * always returns right after queueing the packet.
+	 */
+	int32_t getSetValueWaitTime() { return _setValueWaitTime; }
+
+	/**
+	 * Called by a peer after a value was marked dirty.
+	 *
+	 * @param newValue False when a pending value of the same parameter was replaced.
+	 */
+	void valueDirty(uint64_t peerId, bool newValue);
+
+	/**
+	 * Returns true when value events of received packets are published in batches by _eventBatchThread.
+	 */
+	bool eventBatchingEnabled() { return (bool)_eventBatcher; }
+
+	/**
+	 * Queues a value update for the next batched event of the peer and channel.
+	 *
+	 * @return Returns false when the value needs to be raised immediately, because batching is disabled or the key is excluded
+	 * from batching.
+	 */
+	bool queueEvent(uint64_t peerId, int32_t channel, const std::string& valueKey, const BaseLib::PVariable& value);
+
+	/**
+	 * Returns the interface to send a packet for a peer with. Without "txInterfaceSelection" this is always the interface the
+	 * peer is assigned to.
+	 *
+	 * @param assignedInterface The interface the peer is assigned to.
+	 * @param linkQuality The link statistics of the peer.
+	 * @param coalescingKey When a packet with this key is still queued on one of the interfaces, that interface is returned, so
+	 * the newer packet replaces the queued one instead of overtaking it.
+	 */
+	std::shared_ptr<IIntertechnoInterface> selectTxInterface(const std::shared_ptr<IIntertechnoInterface>& assignedInterface, LinkQuality& linkQuality, const std::shared_ptr<BaseLib::Systems::Packet>& packet, IIntertechnoInterface::TxPriority priority, uint64_t coalescingKey);
+
+	/**
+	 * RPC method "getStatistics". Returns the receive and dispatch statistics of the module.
+	 */
+	BaseLib::PVariable getStatistics(const BaseLib::PRpcClientInfo& clientInfo, const BaseLib::PArray& parameters);
+
+	/**
+	 * RPC method "getUnknownSenders". Returns the senders of received frames not paired to the central together with the
+	 * addresses to use for device creation, most frequent first.
+	 */
+	BaseLib::PVariable getUnknownSenders(const BaseLib::PRpcClientInfo& clientInfo, const BaseLib::PArray& parameters);
+
+	/**
+	 * RPC method "getDutyCycle". Returns the airtime budget, the airtime used during the last hour and the remaining airtime
+	 * (all in milliseconds) of every interface.
+	 */
+	BaseLib::PVariable getDutyCycle(const BaseLib::PRpcClientInfo& clientInfo, const BaseLib::PArray& parameters);
+
+	/**
+	 * RPC method "getLinkQuality". Returns the link statistics of all peers or of the peer passed as first parameter, separately
+	 * for every interface receiving the peer's frames.
+	 */
+	BaseLib::PVariable getLinkQuality(const BaseLib::PRpcClientInfo& clientInfo, const BaseLib::PArray& parameters);
+
+	/**
+	 * RPC method "setScene". Sets STATE or GROUP_STATE of many peers with as few packets as possible. Parameter 1 is an array of
+	 * structs with the entries "peerId", "channel", "value" and optionally "key" ("STATE" (default) or "GROUP_STATE"). When
+	 * parameter 2 is true (default), the method returns after all packets were sent.
+	 */
+	BaseLib::PVariable setScene(const BaseLib::PRpcClientInfo& clientInfo, const BaseLib::PArray& parameters);
 protected:
 	virtual void init();
 	virtual void loadPeers();
 	virtual void savePeers(bool full);
-	virtual void loadVariables() {}
-	virtual void saveVariables() {}
+	virtual void loadVariables();
+	virtual void saveVariables();
 	std::shared_ptr<MyPeer> createPeer(uint32_t deviceType, int32_t address, std::string serialNumber, bool save = true);
 	void deletePeer(uint64_t id);
 
 	std::pair<int32_t, int32_t> getOldItGroupStartCodeAndChannel(int32_t address);
+
+	//{{{ Peer loading
+	/**
+	 * Shared state of the threads loading the peers at startup. Every thread takes the next peer not loaded yet. loaded is set
+	 * to 1 for every peer loaded successfully. When lazy is true, only MyPeer::loadIndex() is called. Otherwise peers are
+	 * materialized before they are published, also when their index is read from the peer state file.
+	 */
+	struct PeerLoadJob
+	{
+		bool lazy = false;
+		std::vector<PeerStateFile::PeerEntry> stateFileEntries; //Same order as peers. Empty when loading from the database.
+		std::vector<PMyPeer> peers;
+		std::vector<uint8_t> loaded;
+		std::atomic<uint32_t> nextPeer{0};
+	};
+
+	void loadPeersThread(PeerLoadJob* job);
+	//}}}
+
+	//{{{ Peer state file
+	/**
+	 * Path of the peer state file (see PeerStateFile). Empty when disabled. _peerGeneration is stored as central variable 0 and
+	 * incremented whenever a peer is published or unpublished. The file is rewritten by savePeers() and on dispose when the
+	 * generation differs from _peerStateFileGeneration.
+	 */
+	std::string _peerStateFile;
+	std::atomic<uint64_t> _peerGeneration{0};
+	uint64_t _peerStateFileGeneration = (uint64_t)-1;
+
+	/**
+	 * Increments the peer generation and saves it. Called after the peer snapshot was replaced, without
+	 * _peerSnapshotWriteMutex locked, so the database write doesn't block other snapshot updates.
+	 */
+	void peersChanged();
+	void writePeerStateFile();
+	//}}}
+
+	//{{{ Receive queues
+	/**
+	 * Received packets are queued by the interface threads and processed by the dispatch threads, so slow database writes or
+	 * event handling don't delay reading from the devices. Every dispatch thread has its own queue. The peer is resolved before
+	 * queueing and the queue is selected by peer ID, so packets of one peer are always processed in order while packets of
+	 * different peers are processed in parallel.
+	 */
+	std::vector<std::shared_ptr<PacketQueue>> _receiveQueues;
+	std::vector<std::thread> _dispatchThreads;
+
+	void dispatchThread(int32_t index);
+	bool deliverPacket(const PMyPeer& peer, const std::shared_ptr<BaseLib::Systems::Packet>& packet);
+
+	/**
+	 * Finds the peer a packet belongs to. For packets from Elro and old Intertechno devices the channel of the packet is set.
+	 *
+	 * @param recordUnknown When true, unknown senders are added to _unknownSenders. False for copies of frames already
+	 * processed.
+	 * @return Returns the peer or nullptr when the packet is invalid or the sender is unknown.
+	 */
+	PMyPeer resolvePeer(const std::string& senderId, const std::shared_ptr<MyPacket>& myPacket, bool recordUnknown = true);
+	PMyPeer resolvePeer(const std::string& senderId, const std::shared_ptr<MyCulTxPacket>& myPacket, bool recordUnknown = true);
+	//}}}
+
+	//{{{ Repeat suppression
+	/**
+	 * One filter per interface. Filled in init() and not modified afterwards, so it can be read without locking.
+	 */
+	std::unordered_map<std::string, std::shared_ptr<RepeatFilter>> _repeatFilters;
+
+	/**
+	 * Returns true when the frame is a repeat of a frame recently received on the same interface.
+	 */
+	bool isRepeat(const std::string& senderId, uint64_t frameKey);
+	//}}}
+
+	//{{{ Combining
+	/**
+	 * Only set when more than one interface is configured. Copies of a frame heard by several interfaces are processed once.
+	 * While combining is enabled, a peer receives frames from all interfaces, not only from the interface it is assigned to.
+	 */
+	std::shared_ptr<FrameCombiner> _frameCombiner;
+
+	/**
+	 * Returns true when the frame was already received by another interface within the combining window.
+	 */
+	bool isCombinedCopy(const std::string& senderId, uint64_t frameKey, uint8_t rssi);
+	//}}}
+
+	/**
+	 * Only interfaces which received a frame of the peer within this period (in milliseconds) are considered by
+	 * LinkQuality::getBestInterface().
+	 */
+	static const int64_t _linkQualityMaxAge = 86400000;
+
+	//{{{ Scenes
+	/**
+	 * Only one packet is sent per peer, key and value of setScene(), as the packet doesn't depend on the channel. The values of all
+	 * targets are set either way. The packets are queued on the interfaces at once, so every interface sends its share in
+	 * parallel.
+	 */
+	struct SceneTarget
+	{
+		PMyPeer peer;
+		uint32_t channel = 0;
+		bool group = false; //GROUP_STATE instead of STATE
+		bool value = false;
+		bool send = true; //False when the same packet is sent for another target
+	};
+	//}}}
+
+	//{{{ TX interface selection
+	/**
+	 * When enabled, the interface is chosen for every packet from an ordered list of candidates: the interface the peer is
+	 * assigned to, the interfaces which received the peer within _linkQualityMaxAge (best average RSSI first) and all remaining
+	 * interfaces. Candidates which are not connected or don't have enough duty cycle budget are skipped. Of the others the one
+	 * with the shortest TX queue is used, so packets are spread over all sticks and a single failing stick doesn't stop
+	 * sending. On equal queue length the earlier candidate wins.
+	 */
+	struct TxInterfaceSelectionStatistics
+	{
+		std::atomic<uint64_t> selected{0};
+		std::atomic<uint64_t> switched{0}; //Packets not sent by the assigned interface
+		std::atomic<uint64_t> unavailable{0}; //Packets for which no candidate was available
+	};
+
+	bool _txInterfaceSelection = false;
+	TxInterfaceSelectionStatistics _txInterfaceSelectionStatistics;
+	//}}}
+
+	int32_t _setValueWaitTime = 0;
+
+	//{{{ Unknown senders
+	UnknownSenderTable _unknownSenders;
+
+	void recordUnknownSender(UnknownSenderTable::SenderType type, int32_t senderAddress, const std::array<UnknownSenderTable::Candidate, 3>& candidates, uint8_t rssi);
+	static std::string getSenderTypeString(UnknownSenderTable::SenderType type);
+	//}}}
+
+	ChangeDetectionSettings _changeDetectionSettings;
+
+	//{{{ Write-behind
+	/**
+	 * Values changed by received packets or setValue are collected per peer and written by _writeBehindThread every
+	 * _writeBehindInterval milliseconds or as soon as _writeBehindThreshold values are pending. Multiple changes of the same
+	 * value in between result in one write. Pending values are written on dispose and when Homegear shuts down.
+	 */
+	struct WriteBehindStatistics
+	{
+		uint64_t flushes = 0;
+		uint64_t written = 0;
+		uint64_t coalesced = 0;
+		uint32_t lastBatchSize = 0;
+		uint32_t maxBatchSize = 0;
+		int64_t totalFlushTime = 0; //In microseconds
+		int64_t maxFlushTime = 0; //In microseconds
+	};
+
+	int32_t _writeBehindInterval = 0;
+	uint32_t _writeBehindThreshold = 100;
+	std::thread _writeBehindThread;
+	std::mutex _dirtyPeersMutex;
+	std::condition_variable _dirtyPeersConditionVariable;
+	std::unordered_set<uint64_t> _dirtyPeers;
+	uint32_t _pendingValues = 0;
+	bool _stopWriteBehindThread = false;
+	WriteBehindStatistics _writeBehindStatistics;
+
+	void writeBehindThread();
+	void flushDirtyValues();
+	//}}}
+
+	//{{{ Event batching
+	/**
+	 * Value events of received packets are collected by _eventBatcher and published by _eventBatchThread every
+	 * _eventBatchingWindow milliseconds, so a group command switching many peers doesn't cause a burst of single value
+	 * events. Keys in _eventBatchingExcludedKeys are always raised immediately.
+	 */
+	int32_t _eventBatchingWindow = 0;
+	std::unordered_set<std::string> _eventBatchingExcludedKeys;
+	std::shared_ptr<EventBatcher> _eventBatcher;
+	std::thread _eventBatchThread;
+	std::mutex _eventBatchThreadMutex;
+	std::condition_variable _eventBatchThreadConditionVariable;
+	bool _stopEventBatchThread = false;
+
+	void eventBatchThread();
+	void publishBatchedEvents();
+	//}}}
+
+	void printStatistics(const BaseLib::PVariable& statistics, const std::string& indentation, std::ostringstream& stringStream);
+
+	//{{{ Peer snapshot
+	/**
+	 * Immutable copy of the peer maps. The receive path only reads the current snapshot, so it never waits on administrative
+	 * operations holding _peersMutex. Changes are made on a copy which is then published (copy on write).
+	 *
+	 * Elro and old Intertechno devices are not addressed by the full sender address of a frame. To avoid scanning all peers
+	 * for every frame, these peers are indexed by interface ID and (device type << 32 | derived address). CULTX sensors
+	 * are indexed the same way using their CULTX address.
+	 */
+	struct PeerSnapshot
+	{
+		std::unordered_map<int32_t, PMyPeer> peersByAddress;
+		std::unordered_map<std::string, PMyPeer> peersBySerial;
+		std::map<uint64_t, PMyPeer> peersById;
+		std::unordered_map<std::string, std::unordered_map<uint64_t, PMyPeer>> addressIndex;
+		std::unordered_map<uint64_t, std::pair<std::string, uint64_t>> addressIndexKeys;
+
+		void add(const PMyPeer& peer);
+		void remove(uint64_t peerId);
+		/**
+		 * @param anyInterface When true and the peer is not assigned to the given interface, peers of all other interfaces are searched.
+		 */
+		PMyPeer getPeerByDerivedAddress(const std::string& interfaceId, uint32_t deviceType, int32_t address, bool anyInterface = false) const;
+	};
+	typedef std::shared_ptr<const PeerSnapshot> PPeerSnapshot;
+
+	std::mutex _peerSnapshotWriteMutex;
+	PPeerSnapshot _peerSnapshot = std::make_shared<PeerSnapshot>();
+
+	PPeerSnapshot getPeerSnapshot() { return std::atomic_load(&_peerSnapshot); }
+	void unpublishPeer(uint64_t peerId);
+	static bool isIndexedDeviceType(uint32_t deviceType) { return deviceType == 0x24 || deviceType == 0x30 || deviceType == 0x33 || deviceType == 0x50; }
+	static uint64_t getAddressIndexKey(uint32_t deviceType, int32_t address) { return ((uint64_t)deviceType << 32) | (uint32_t)address; }
+	//}}}
 };
 
 }
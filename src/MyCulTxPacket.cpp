@@ -28,6 +28,7 @@
  */
 
 #include "MyCulTxPacket.h"
+#include "MyPacket.h"
 
 #include "GD.h"
 
@@ -37,38 +38,33 @@ MyCulTxPacket::MyCulTxPacket()
 {
 }
 
-MyCulTxPacket::MyCulTxPacket(std::string& rawPacket)
+MyCulTxPacket::MyCulTxPacket(std::string_view rawPacket)
 {
 	_timeReceived = BaseLib::HelperFunctions::getTime();
-	_packet = rawPacket;
-
-	std::string rawString = _packet.substr(1);
-	auto packetVector = GD::bl->hf.getUBinary(rawString);
-	//_senderAddress = BaseLib::BitReaderWriter::getPosition8(packetVector, 11, 4);
-	_senderAddress = (  ((BaseLib::BitReaderWriter::getPosition8(packetVector, 8, 4)) << 3) + ((BaseLib::BitReaderWriter::getPosition8(packetVector, 12, 4)) >> 1));
-	_type = BaseLib::BitReaderWriter::getPosition8(packetVector, 4, 4);
 	_rssi = 0;
+	_packet.assign(rawPacket.data(), rawPacket.size()); //Returned by hexString() for logging
 
 	// 1010 0000 1111 1101 0111 0010
 	// A		0	1	 0	  7	   8		378C16  <-- example packet
 	// 1010 0000 0001 0000 0111 1000
-	// 0	4	 8	  12   16	20   Position of bits
-	auto value_ten = BaseLib::BitReaderWriter::getPosition8(packetVector, 16, 4);
-	auto value_one = BaseLib::BitReaderWriter::getPosition8(packetVector, 20, 4);
-	auto value_dotone = BaseLib::BitReaderWriter::getPosition8(packetVector, 24, 4);
+	// 0	1	 2	  3	   4	5	 6	Index of nibbles after the leading "t"
+	if(rawPacket.size() < 8) return;
+	int32_t nibbles[7];
+	for(int32_t i = 0; i < 7; i++)
+	{
+		nibbles[i] = MyPacket::parseHexNibble(rawPacket[i + 1]);
+		if(nibbles[i] == -1) return;
+	}
 
-	float rawvalue = value_ten*10;
-	rawvalue += value_one;
-	rawvalue += value_dotone*0.1;
+	_senderAddress = (nibbles[2] << 3) + (nibbles[3] >> 1);
+	_type = nibbles[1];
 
+	_value = nibbles[4] * 100 + nibbles[5] * 10 + nibbles[6];
 	// Value of temp adjusted by -50
-	if(_type==0) rawvalue -= 50;
-
-	_payload = std::to_string(rawvalue);
-
+	if(_type == 0) _value -= 500;
+	_valid = true;
 }
 
-
 MyCulTxPacket::MyCulTxPacket(int32_t senderAddress, std::string& payload) : _payload(payload)
 {
 	_senderAddress = senderAddress;
@@ -79,6 +75,14 @@ MyCulTxPacket::~MyCulTxPacket()
 	_payload.clear();
 }
 
+std::string MyCulTxPacket::getPayload()
+{
+	if(!_payload.empty() || !_valid) return _payload;
+	//Only used for logging of received packets, so the string is not kept.
+	int32_t absoluteValue = _value < 0 ? -_value : _value;
+	return (_value < 0 ? "-" : "") + std::to_string(absoluteValue / 10) + "." + std::to_string(absoluteValue % 10);
+}
+
 std::string MyCulTxPacket::hexString()
 {
 	try
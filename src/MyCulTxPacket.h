@@ -31,6 +31,7 @@
 #define MYCULTXPACKET_H_
 
 #include <cstdint>
+#include <string_view>
 
 #include <homegear-base/BaseLib.h>
 
@@ -42,18 +43,29 @@ class MyCulTxPacket : public BaseLib::Systems::Packet
 {
     public:
 	MyCulTxPacket();
-	MyCulTxPacket(std::string& rawPacket);
+	MyCulTxPacket(std::string_view rawPacket);
 	MyCulTxPacket(int32_t senderAddress, std::string& payload);
         virtual ~MyCulTxPacket();
 
         int32_t senderAddress() { return _senderAddress; }
         int32_t getChannel() { return _channel; }
         void setChannel(int32_t value) { _channel = value; }
-        std::string getPayload() { return _payload; }
+        std::string getPayload();
         void setPacket(std::string& value) { _packet = value; }
         std::string hexString();
         uint8_t getRssi() { return _rssi; }
         uint8_t getType() { return _type; }
+        bool isValid() { return _valid; }
+
+        /**
+         * Returns the decoded value in tenths (0.1 °C for temperature, 0.1 % RH for humidity).
+         */
+        int32_t getValue() { return _value; }
+
+        /**
+         * Returns a value identifying the content of the frame (everything but the RSSI). Used to detect repeated frames.
+         */
+        uint64_t getFrameKey() { return (1ull << 62) | ((uint64_t)(_type & 0xF) << 48) | ((uint64_t)(uint16_t)_value << 32) | (uint32_t)_senderAddress; }
 
     protected:
         int32_t _senderAddress = 0;
@@ -62,7 +74,8 @@ class MyCulTxPacket : public BaseLib::Systems::Packet
         int32_t _channel = -1;
         uint8_t _rssi = 0;
         int32_t _type = -1;
-
+        int32_t _value = 0;
+        bool _valid = false;
 };
 
 typedef std::shared_ptr<MyCulTxPacket> PMyCulTxPacket;
@@ -76,6 +76,36 @@ std::shared_ptr<BaseLib::Systems::ICentral> MyFamily::initializeCentral(uint32_t
 	return std::shared_ptr<MyCentral>(new MyCentral(deviceId, serialNumber, this));
 }
 
+int32_t MyFamily::getSettingInteger(std::string name, int32_t defaultValue)
+{
+	try
+	{
+		BaseLib::HelperFunctions::toLower(name);
+		auto setting = getFamilySetting(name);
+		if(setting) return setting->integerValue;
+	}
+	catch(const std::exception& ex)
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+	return defaultValue;
+}
+
+std::string MyFamily::getSettingString(std::string name, std::string defaultValue)
+{
+	try
+	{
+		BaseLib::HelperFunctions::toLower(name);
+		auto setting = getFamilySetting(name);
+		if(setting) return setting->stringValue;
+	}
+	catch(const std::exception& ex)
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+	return defaultValue;
+}
+
 PVariable MyFamily::getPairingInfo()
 {
 	try
@@ -49,6 +49,19 @@ public:
 
 	virtual bool hasPhysicalInterface() { return true; }
 	virtual PVariable getPairingInfo();
+
+	/**
+	 * Returns the value of a setting in the section "General" of "intertechno.conf".
+	 *
+	 * @param name The name of the setting (case insensitive).
+	 * @param defaultValue The value to return when the setting is not defined.
+	 */
+	int32_t getSettingInteger(std::string name, int32_t defaultValue);
+
+	/**
+	 * {@see getSettingInteger}
+	 */
+	std::string getSettingString(std::string name, std::string defaultValue);
 protected:
 	virtual std::shared_ptr<BaseLib::Systems::ICentral> initializeCentral(uint32_t deviceId, int32_t address, std::string serialNumber);
 	virtual void createCentral();
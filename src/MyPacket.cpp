@@ -38,16 +38,34 @@ MyPacket::MyPacket()
 {
 }
 
-MyPacket::MyPacket(std::string& rawPacket)
+MyPacket::MyPacket(std::string_view rawPacket)
 {
 	_timeReceived = BaseLib::HelperFunctions::getTime();
-	_packet = rawPacket.at(0) == 'i' && rawPacket.size() > 3 ? rawPacket.substr(1, rawPacket.size() - 3) : rawPacket;
-	_senderAddress = 0;
+	if(!decode(rawPacket, _command) && GD::bl->debugLevel >= 5) GD::out.printDebug("Debug: Could not decode packet of size " + std::to_string(rawPacket.size()));
+}
+
+MyPacket::MyPacket(int32_t senderAddress, std::string& payload) : _payload(payload)
+{
+	_command.senderAddress = senderAddress;
+}
+
+MyPacket::~MyPacket()
+{
+	_payload.clear();
+}
 
-    if(GD::bl->debugLevel >= 5) GD::out.printDebug("Debug: Packet size is " + std::to_string(_packet.size()));
+bool MyPacket::decode(std::string_view rawPacket, Command& command)
+{
+	command = Command();
 
-	std::string rssiString = _packet.substr(_packet.size() - 2, 2);
-	int32_t rssiDevice = BaseLib::Math::getNumber(rssiString);
+	if(!rawPacket.empty() && rawPacket.front() == 'i') rawPacket.remove_prefix(1);
+	while(!rawPacket.empty() && (rawPacket.back() == '\n' || rawPacket.back() == '\r')) rawPacket.remove_suffix(1);
+	if(rawPacket.size() != 8 && rawPacket.size() != 18) return false;
+
+	int32_t rssiHigh = parseHexNibble(rawPacket.at(rawPacket.size() - 2));
+	int32_t rssiLow = parseHexNibble(rawPacket.at(rawPacket.size() - 1));
+	if(rssiHigh == -1 || rssiLow == -1) return false;
+	int32_t rssiDevice = (rssiHigh << 4) | rssiLow;
 	//1) Read the RSSI status register
 	//2) Convert the reading from a hexadecimal
 	//number to a decimal number (RSSI_dec)
@@ -57,52 +75,55 @@ MyPacket::MyPacket(std::string& rawPacket)
 	//(RSSI_dec)/2 – RSSI_offset
 	if(rssiDevice >= 128) rssiDevice = ((rssiDevice - 256) / 2) - 74;
 	else rssiDevice = (rssiDevice / 2) - 74;
-	_rssi = (uint8_t)(rssiDevice * -1);
+	command.rssi = (uint8_t)(rssiDevice * -1);
 
-	if(_packet.size() == 8)
+	if(rawPacket.size() == 8)
 	{
-		_channel = 0;
-		_senderAddress = 0;
+		command.channel = 0;
+		command.tristate = true;
 		int32_t j = 0;
-		for(int32_t i = _packet.size() - 4; i >= 0; i--)
+		for(int32_t i = rawPacket.size() - 4; i >= 0; i--)
 		{
-			_senderAddress |= (parseNibbleSmall(_packet.at(i)) << j);
+			command.senderAddress |= (parseNibbleSmall(rawPacket[i]) << j);
 			j += 2;
 		}
 
-		_payload = parseNibbleStringSmall(_packet.at(_packet.size() - 3));
+		command.bits = parseNibbleSmall(rawPacket[rawPacket.size() - 3]);
 	}
-	else if(_packet.size() == 18)
+	else
 	{
-		_channel = 0;
-		_senderAddress = 0;
+		command.channel = 0;
 		int32_t j = 0;
-		for(int32_t i = _packet.size() - 3; i >= (signed)_packet.size() - 4; i--)
+		for(int32_t i = rawPacket.size() - 3; i >= (signed)rawPacket.size() - 4; i--)
 		{
-			_channel |= (parseNibble(_packet.at(i)) << j);
+			command.channel |= (parseNibble(rawPacket[i]) << j);
 			j += 2;
 		}
-		_channel++;
+		command.channel++;
 
 		j = 0;
-		for(int32_t i = _packet.size() - 6; i >= 0; i--)
+		for(int32_t i = rawPacket.size() - 6; i >= 0; i--)
 		{
-			_senderAddress |= (parseNibble(_packet.at(i)) << j);
+			command.senderAddress |= (parseNibble(rawPacket[i]) << j);
 			j += 2;
 		}
 
-		_payload = parseNibbleString(_packet.at(_packet.size() - 5));
+		command.bits = parseNibble(rawPacket[rawPacket.size() - 5]);
 	}
-}
 
-MyPacket::MyPacket(int32_t senderAddress, std::string& payload) : _payload(payload)
-{
-	_senderAddress = senderAddress;
+	command.valid = true;
+	return true;
 }
 
-MyPacket::~MyPacket()
+std::string MyPacket::getPayload()
 {
-	_payload.clear();
+	if(!_payload.empty() || !_command.valid) return _payload;
+	//Only used for logging of received packets, so the string is not kept.
+	char setChar = _command.tristate ? 'F' : '1';
+	std::string payload(2, '0');
+	if(_command.bits & 2) payload[0] = setChar;
+	if(_command.bits & 1) payload[1] = setChar;
+	return payload;
 }
 
 uint8_t MyPacket::parseNibble(char nibble)
@@ -121,22 +142,6 @@ uint8_t MyPacket::parseNibble(char nibble)
 	return 0;
 }
 
-std::string MyPacket::parseNibbleString(char nibble)
-{
-	switch(nibble)
-	{
-		case '5':
-			return "00";
-		case '6':
-			return "01";
-		case '9':
-			return "10";
-		case 'A':
-			return "11";
-	}
-	return "00";
-}
-
 uint8_t MyPacket::parseNibbleSmall(char nibble)
 {
 	switch(nibble)
@@ -153,20 +158,22 @@ uint8_t MyPacket::parseNibbleSmall(char nibble)
 	return 0;
 }
 
-std::string MyPacket::parseNibbleStringSmall(char nibble)
+int32_t MyPacket::parseHexNibble(char nibble)
 {
-	switch(nibble)
-	{
-		case '0':
-			return "00";
-		case '1':
-			return "0F";
-		case '4':
-			return "F0";
-		case '5':
-			return "FF";
-	}
-	return "00";
+	if(nibble >= '0' && nibble <= '9') return nibble - '0';
+	if(nibble >= 'A' && nibble <= 'F') return nibble - 'A' + 10;
+	if(nibble >= 'a' && nibble <= 'f') return nibble - 'a' + 10;
+	return -1;
+}
+
+int32_t MyPacket::getAirtime()
+{
+	//Calculated without building the string, so queueing a packet doesn't allocate it.
+	int32_t symbols = 0;
+	if(!_packet.empty()) symbols = _packet.size();
+	else symbols = ((_command.senderAddress & 0xFFFFFC00) ? 30 : 10) + getPayload().size();
+	if(symbols <= 12) return (symbols * 8 + 32) * 350; //Tristate
+	return (symbols * 8 + 51) * 250;
 }
 
 std::string& MyPacket::hexString()
@@ -174,28 +181,8 @@ std::string& MyPacket::hexString()
 	try
 	{
 		if(!_packet.empty()) return _packet;
-		if(_senderAddress & 0xFFFFFC00)
-		{
-			_packet.reserve(32);
-			for(int32_t i = 25; i >= 0; i--)
-			{
-				_packet.push_back(_senderAddress & (1 << i) ? '1' : '0');
-			}
-			_packet.insert(_packet.end(), _payload.begin(), _payload.end());
-			for(int32_t i = 3; i >= 0; i--)
-			{
-				_packet.push_back(_senderAddress & (1 << i) ? '1' : '0');
-			}
-		}
-		else
-		{
-			_packet.reserve(12);
-			for(int32_t i = 9; i >= 0; i--)
-			{
-				_packet.push_back(_senderAddress & (1 << i) ? 'F' : '0');
-			}
-			_packet.insert(_packet.end(), _payload.begin(), _payload.end());
-		}
+		_packet.reserve(32);
+		appendHexString(_packet);
 		return _packet;
 	}
 	catch(const std::exception& ex)
@@ -205,4 +192,34 @@ std::string& MyPacket::hexString()
     _packet.clear();
     return _packet;
 }
+
+void MyPacket::appendHexString(std::string& buffer)
+{
+	if(!_packet.empty())
+	{
+		buffer.append(_packet);
+		return;
+	}
+	std::string payload = getPayload(); //Fits into the small string buffer
+	if(_command.senderAddress & 0xFFFFFC00)
+	{
+		for(int32_t i = 25; i >= 0; i--)
+		{
+			buffer.push_back(_command.senderAddress & (1 << i) ? '1' : '0');
+		}
+		buffer.append(payload);
+		for(int32_t i = 3; i >= 0; i--)
+		{
+			buffer.push_back(_command.senderAddress & (1 << i) ? '1' : '0');
+		}
+	}
+	else
+	{
+		for(int32_t i = 9; i >= 0; i--)
+		{
+			buffer.push_back(_command.senderAddress & (1 << i) ? 'F' : '0');
+		}
+		buffer.append(payload);
+	}
+}
 }
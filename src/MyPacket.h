@@ -31,6 +31,7 @@
 #define MYPACKET_H_
 
 #include <cstdint>
+#include <string_view>
 
 #include <homegear-base/BaseLib.h>
 
@@ -40,30 +41,78 @@ namespace MyFamily
 class MyPacket : public BaseLib::Systems::Packet
 {
     public:
+        /**
+         * The decoded content of a received frame. Filled by decode() without any heap allocation.
+         */
+        struct Command
+        {
+            int32_t senderAddress = 0;
+            int32_t channel = -1;
+            uint8_t bits = 0; //Bit 1: group bit, bit 0: on/off bit
+            uint8_t rssi = 0;
+            bool tristate = false; //True for the short tristate frames of Elro and old Intertechno devices
+            bool valid = false;
+
+            bool isGroup() const { return !tristate && (bits & 2); }
+            bool isOn() const { return bits & 1; }
+            bool hasFloatingBit() const { return tristate && bits != 0; }
+        };
+
         MyPacket();
-        MyPacket(std::string& rawPacket);
+        MyPacket(std::string_view rawPacket);
         MyPacket(int32_t senderAddress, std::string& payload);
         virtual ~MyPacket();
 
-        int32_t senderAddress() { return _senderAddress; }
-        int32_t getChannel() { return _channel; }
-        void setChannel(int32_t value) { _channel = value; }
-        std::string getPayload() { return _payload; }
+        /**
+         * Decodes a raw line as received from a CUL compatible device (with or without the leading "i" and the trailing line break).
+         *
+         * @param rawPacket The raw line.
+         * @param[out] command The decoded frame.
+         * @return Returns true when the line could be decoded.
+         */
+        static bool decode(std::string_view rawPacket, Command& command);
+
+        /**
+         * Returns the value of a hexadecimal digit or -1. Also used by MyCulTxPacket.
+         */
+        static int32_t parseHexNibble(char nibble);
+
+        const Command& getCommand() { return _command; }
+        bool isValid() { return _command.valid; }
+        int32_t senderAddress() { return _command.senderAddress; }
+        int32_t getChannel() { return _command.channel; }
+        void setChannel(int32_t value) { _command.channel = value; }
+        std::string getPayload();
         void setPacket(std::string& value) { _packet = value; }
         std::string& hexString();
-        uint8_t getRssi() { return _rssi; }
+
+        /**
+         * Appends the frame as sent to the device to buffer. Unlike hexString(), the string is not stored in the packet.
+         */
+        void appendHexString(std::string& buffer);
+        uint8_t getRssi() { return _command.rssi; }
+
+        /**
+         * Returns the estimated time on air of one transmission of the frame in microseconds. Tristate frames use a base pulse
+         * of 350 µs (8 pulses per symbol plus a sync of 32 pulses), self-learning frames a base pulse of 250 µs (8 pulses per
+         * bit plus start and stop of 51 pulses).
+         */
+        int32_t getAirtime();
+
+        /**
+         * Returns a value identifying the content of the frame (everything but the RSSI). Used to detect repeated frames. Layout:
+         * bit 63 marks Intertechno frames, bits 48 to 55 hold the channel, bit 40 the tristate flag, bits 32 to 39 the command
+         * bits and bits 0 to 31 the address.
+         */
+        uint64_t getFrameKey() { return (1ull << 63) | ((uint64_t)(uint8_t)_command.channel << 48) | ((uint64_t)_command.tristate << 40) | ((uint64_t)_command.bits << 32) | (uint32_t)_command.senderAddress; }
 
     protected:
-        int32_t _senderAddress = 0;
+        Command _command;
         std::string _packet;
         std::string _payload;
-        int32_t _channel = -1;
-        uint8_t _rssi = 0;
 
-        uint8_t parseNibble(char nibble);
-        std::string parseNibbleString(char nibble);
-        uint8_t parseNibbleSmall(char nibble);
-        std::string parseNibbleStringSmall(char nibble);
+        static uint8_t parseNibble(char nibble);
+        static uint8_t parseNibbleSmall(char nibble);
 };
 
 typedef std::shared_ptr<MyPacket> PMyPacket;
@@ -33,11 +33,14 @@
 #include "MyPacket.h"
 #include "MyCentral.h"
 
+#include <cmath>
 #include <iomanip>
 #include "MyCulTxPacket.h"
 
 namespace MyFamily
 {
+const std::array<std::string, (size_t)MyPeer::HotParameter::count> MyPeer::_hotParameterKeys{ "STATE", "GROUP_STATE", "RSSI_DEVICE", "TEMPERATURE", "HUMIDITY" };
+
 std::shared_ptr<BaseLib::Systems::ICentral> MyPeer::getCentral()
 {
 	try
@@ -55,6 +58,7 @@ std::shared_ptr<BaseLib::Systems::ICentral> MyPeer::getCentral()
 
 MyPeer::MyPeer(uint32_t parentID, IPeerEventSink* eventHandler) : BaseLib::Systems::Peer(GD::bl, parentID, eventHandler)
 {
+	_materialized = true; //New peer, there is nothing to load
 	init();
 }
 
@@ -109,6 +113,7 @@ void MyPeer::homegearShuttingDown()
 	try
 	{
 		_shuttingDown = true;
+		saveDirtyValues();
 		Peer::homegearShuttingDown();
 	}
 	catch(const std::exception& ex)
@@ -121,6 +126,7 @@ std::string MyPeer::handleCliCommand(std::string command)
 {
 	try
 	{
+		materialize();
 		std::ostringstream stringStream;
 
 		if(command == "help")
@@ -273,6 +279,8 @@ void MyPeer::setPhysicalInterfaceId(std::string id)
 		setPhysicalInterface(GD::defaultPhysicalInterface);
 		saveVariable(19, _physicalInterfaceId);
 	}
+
+	setDirty();
 }
 
 void MyPeer::setPhysicalInterface(std::shared_ptr<IIntertechnoInterface> interface)
@@ -294,6 +302,7 @@ void MyPeer::loadVariables(BaseLib::Systems::ICentral* central, std::shared_ptr<
 	{
 		if(!rows) rows = _bl->db->getPeerVariables(_peerID);
 		Peer::loadVariables(central, rows);
+		_variablesLoaded = true;
 
 		_rpcDevice = GD::family->getRpcDevices()->find(_deviceType, _firmwareVersion, -1);
 		if(!_rpcDevice) return;
@@ -331,6 +340,13 @@ void MyPeer::saveVariables()
 }
 
 bool MyPeer::load(BaseLib::Systems::ICentral* central)
+{
+	if(!loadIndex(central)) return false;
+	materialize(central);
+	return true;
+}
+
+bool MyPeer::loadIndex(BaseLib::Systems::ICentral* central)
 {
 	try
 	{
@@ -343,11 +359,78 @@ bool MyPeer::load(BaseLib::Systems::ICentral* central)
 		}
 
 		initializeTypeString();
-		std::string entry;
-		loadConfig();
-		initializeCentralConfig();
+		serviceMessages.reset(new BaseLib::Systems::ServiceMessages(_bl, _peerID, _serialNumber, this));
+		return true;
+	}
+	catch(const std::exception& ex)
+    {
+    	GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+    }
+    return false;
+}
+
+bool MyPeer::loadIndex(const PeerStateFile::PeerEntry& entry)
+{
+	try
+	{
+		setDeviceType(entry.deviceType);
+		setFirmwareVersion(entry.firmwareVersion);
+		_rpcDevice = GD::family->getRpcDevices()->find(_deviceType, _firmwareVersion, -1);
+		if(!_rpcDevice) return false;
 
+		_physicalInterfaceId = entry.interfaceId;
+		if(!_physicalInterfaceId.empty() && GD::physicalInterfaces.find(_physicalInterfaceId) != GD::physicalInterfaces.end()) setPhysicalInterface(GD::physicalInterfaces.at(_physicalInterfaceId));
+		if(!_physicalInterface) _physicalInterface = GD::defaultPhysicalInterface;
+
+		initializeTypeString();
 		serviceMessages.reset(new BaseLib::Systems::ServiceMessages(_bl, _peerID, _serialNumber, this));
+		return true;
+	}
+	catch(const std::exception& ex)
+    {
+    	GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+    }
+    return false;
+}
+
+PeerStateFile::PeerEntry MyPeer::getIndexEntry()
+{
+	PeerStateFile::PeerEntry entry;
+	entry.id = _peerID;
+	entry.address = _address;
+	entry.deviceType = _deviceType;
+	entry.firmwareVersion = _firmwareVersion;
+	entry.serialNumber = _serialNumber;
+	entry.interfaceId = _physicalInterfaceId;
+	return entry;
+}
+
+void MyPeer::materialize()
+{
+	if(_materialized) return;
+	std::shared_ptr<BaseLib::Systems::ICentral> central = getCentral();
+	if(central) materialize(central.get());
+}
+
+void MyPeer::materialize(BaseLib::Systems::ICentral* central)
+{
+	try
+	{
+		if(_materialized) return;
+		std::lock_guard<std::mutex> materializeGuard(_materializeMutex);
+		if(_materialized || !_rpcDevice) return;
+
+		if(!_variablesLoaded)
+		{
+			//Loaded from the peer state file. Device description and interface are already set, so only the base class
+			//variables are loaded.
+			std::shared_ptr<BaseLib::Database::DataTable> rows = _bl->db->getPeerVariables(_peerID);
+			Peer::loadVariables(central, rows);
+			_variablesLoaded = true;
+		}
+
+		loadConfig();
+		initializeCentralConfig();
 		serviceMessages->load();
 
 		std::unordered_map<uint32_t, std::unordered_map<std::string, BaseLib::Systems::RpcConfigurationParameter>>::iterator channelIterator = configCentral.find(0);
@@ -361,13 +444,159 @@ bool MyPeer::load(BaseLib::Systems::ICentral* central)
 			}
 		}
 
-		return true;
+		_materialized = true;
 	}
 	catch(const std::exception& ex)
     {
     	GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
     }
-    return false;
+}
+
+void MyPeer::initializeCentralConfig()
+{
+	Peer::initializeCentralConfig();
+	initializeHotParameters();
+}
+
+void MyPeer::initializeHotParameters()
+{
+	try
+	{
+		for(auto& channels : _hotParameters)
+		{
+			channels.clear();
+		}
+
+		uint32_t channelCount = 0;
+		for(auto& channelIterator : valuesCentral)
+		{
+			if(channelIterator.first >= _maxHotParameterChannels) continue;
+			if(channelIterator.first >= channelCount) channelCount = channelIterator.first + 1;
+			for(size_t i = 0; i < _hotParameterKeys.size(); i++)
+			{
+				auto parameterIterator = channelIterator.second.find(_hotParameterKeys[i]);
+				if(parameterIterator == channelIterator.second.end() || !parameterIterator->second.rpcParameter) continue;
+				if(_hotParameters[i].size() <= channelIterator.first) _hotParameters[i].resize(channelIterator.first + 1, nullptr);
+				_hotParameters[i][channelIterator.first] = &parameterIterator->second;
+			}
+		}
+		_multiChannel = valuesCentral.find(2) != valuesCentral.end(); //At least two channels in device description?
+
+		_eventSource = "device-" + std::to_string(_peerID);
+		_channelAddresses.clear();
+		_channelAddresses.reserve(channelCount);
+		for(uint32_t i = 0; i < channelCount; i++)
+		{
+			_channelAddresses.push_back(_serialNumber + ":" + std::to_string(i));
+		}
+	}
+	catch(const std::exception& ex)
+    {
+    	GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+    }
+}
+
+BaseLib::Systems::RpcConfigurationParameter* MyPeer::getHotParameter(HotParameter parameter, uint32_t channel)
+{
+	auto& channels = _hotParameters[(size_t)parameter];
+	return channel < channels.size() ? channels[channel] : nullptr;
+}
+
+uint64_t MyPeer::getCoalescingKey(HotParameter parameter, uint32_t channel)
+{
+	return (_peerID << 16) | ((uint64_t)(channel & 0xFF) << 8) | ((uint64_t)parameter + 1);
+}
+
+std::string MyPeer::getChannelAddress(uint32_t channel)
+{
+	if(channel < _channelAddresses.size()) return _channelAddresses[channel];
+	return _serialNumber + ":" + std::to_string(channel);
+}
+
+void MyPeer::saveValue(BaseLib::Systems::RpcConfigurationParameter& parameter, uint32_t channel, const std::string& valueKey, std::vector<uint8_t>& parameterData)
+{
+	try
+	{
+		setDirty();
+		std::shared_ptr<MyCentral> central = std::dynamic_pointer_cast<MyCentral>(getCentral());
+		if(central && central->writeBehindEnabled() && !_shuttingDown)
+		{
+			bool newValue = false;
+			{
+				std::lock_guard<std::mutex> dirtyValuesGuard(_dirtyValuesMutex);
+				auto result = _dirtyValues.emplace(std::make_pair(channel, valueKey), DirtyValue());
+				newValue = result.second;
+				result.first->second.databaseId = parameter.databaseId;
+				result.first->second.data = parameterData;
+			}
+			central->valueDirty(_peerID, newValue);
+			return;
+		}
+
+		if(parameter.databaseId > 0) saveParameter(parameter.databaseId, parameterData);
+		else saveParameter(0, ParameterGroup::Type::Enum::variables, channel, valueKey, parameterData);
+	}
+	catch(const std::exception& ex)
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+}
+
+bool MyPeer::isSignificantChange(HotParameter hotParameter, BaseLib::Systems::RpcConfigurationParameter& parameter, int32_t value, int32_t deadband, const ChangeDetectionSettings& settings)
+{
+	try
+	{
+		int64_t now = BaseLib::HelperFunctions::getTime();
+		int64_t& lastValueReport = _lastValueReport.at((size_t)hotParameter);
+
+		std::vector<uint8_t> currentData = parameter.getBinaryData();
+		bool significant = currentData.empty() || (settings.heartbeat > 0 && now - lastValueReport >= (int64_t)settings.heartbeat * 1000);
+		if(!significant)
+		{
+			//Physical integer, big endian, signed
+			uint32_t rawValue = (currentData.at(0) & 0x80) ? 0xFFFFFFFF : 0;
+			for(auto byte : currentData)
+			{
+				rawValue = (rawValue << 8) | byte;
+			}
+			int32_t currentValue = (int32_t)rawValue;
+			int32_t difference = std::abs(value - currentValue);
+			significant = difference > 0 && difference >= deadband && difference * 100 >= settings.relativeDeadband * std::abs(currentValue);
+		}
+
+		if(significant) lastValueReport = now;
+		return significant;
+	}
+	catch(const std::exception& ex)
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+	return true;
+}
+
+uint32_t MyPeer::saveDirtyValues()
+{
+	try
+	{
+		std::map<std::pair<uint32_t, std::string>, DirtyValue> dirtyValues;
+		{
+			std::lock_guard<std::mutex> dirtyValuesGuard(_dirtyValuesMutex);
+			dirtyValues.swap(_dirtyValues);
+		}
+		if(deleting || dirtyValues.empty()) return 0;
+
+		for(auto& dirtyValue : dirtyValues)
+		{
+			if(dirtyValue.second.databaseId > 0) saveParameter(dirtyValue.second.databaseId, dirtyValue.second.data);
+			else saveParameter(0, ParameterGroup::Type::Enum::variables, dirtyValue.first.first, dirtyValue.first.second, dirtyValue.second.data);
+		}
+		return dirtyValues.size();
+	}
+	catch(const std::exception& ex)
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+	return 0;
 }
 
 void MyPeer::setRssiDevice(uint8_t rssi)
@@ -376,21 +605,21 @@ void MyPeer::setRssiDevice(uint8_t rssi)
 	{
 		if(_disposing || rssi == 0) return;
 		uint32_t time = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-		if(valuesCentral.find(0) != valuesCentral.end() && valuesCentral.at(0).find("RSSI_DEVICE") != valuesCentral.at(0).end() && (time - _lastRssiDevice) > 10)
+		BaseLib::Systems::RpcConfigurationParameter* parameter = getHotParameter(HotParameter::rssiDevice, 0);
+		if(parameter && (time - _lastRssiDevice) > 10)
 		{
-			_lastRssiDevice = time;
-			BaseLib::Systems::RpcConfigurationParameter& parameter = valuesCentral.at(0).at("RSSI_DEVICE");
 			std::vector<uint8_t> parameterData{ rssi };
-			parameter.setBinaryData(parameterData);
+			if(parameter->equals(parameterData)) return; //The full history is available through "getLinkQuality"
+			_lastRssiDevice = time;
+			parameter->setBinaryData(parameterData);
 
-			std::shared_ptr<std::vector<std::string>> valueKeys(new std::vector<std::string>({std::string("RSSI_DEVICE")}));
+			std::shared_ptr<std::vector<std::string>> valueKeys(new std::vector<std::string>({_hotParameterKeys.at((size_t)HotParameter::rssiDevice)}));
 			std::shared_ptr<std::vector<PVariable>> rpcValues(new std::vector<PVariable>());
-			rpcValues->push_back(parameter.rpcParameter->convertFromPacket(parameterData, parameter.mainRole(), false));
+			rpcValues->push_back(parameter->rpcParameter->convertFromPacket(parameterData, parameter->mainRole(), false));
 
-            std::string eventSource = "device-" + std::to_string(_peerID);
-            std::string address = _serialNumber + ":0";
-            raiseEvent(eventSource, _peerID, 0, valueKeys, rpcValues);
-            raiseRPCEvent(eventSource, _peerID, 0, address, valueKeys, rpcValues);
+            std::shared_ptr<MyCentral> central = std::dynamic_pointer_cast<MyCentral>(getCentral());
+            if(central) publishValueEvents(central, 0, valueKeys, rpcValues);
+            else raiseValueEvents(0, valueKeys, rpcValues);
 		}
 	}
 	catch(const std::exception& ex)
@@ -400,6 +629,47 @@ void MyPeer::setRssiDevice(uint8_t rssi)
 }
 
 
+void MyPeer::raiseValueEvents(int32_t channel, std::shared_ptr<std::vector<std::string>>& valueKeys, std::shared_ptr<std::vector<PVariable>>& values)
+{
+	try
+	{
+		if(_disposing || valueKeys->empty()) return;
+		std::string address = getChannelAddress(channel);
+		raiseEvent(_eventSource, _peerID, channel, valueKeys, values);
+		raiseRPCEvent(_eventSource, _peerID, channel, address, valueKeys, values);
+	}
+	catch(const std::exception& ex)
+    {
+    	GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+    }
+}
+
+void MyPeer::publishValueEvents(const std::shared_ptr<MyCentral>& central, int32_t channel, std::shared_ptr<std::vector<std::string>>& valueKeys, std::shared_ptr<std::vector<PVariable>>& values)
+{
+	try
+	{
+		if(!central->eventBatchingEnabled())
+		{
+			raiseValueEvents(channel, valueKeys, values);
+			return;
+		}
+
+		std::shared_ptr<std::vector<std::string>> immediateValueKeys = std::make_shared<std::vector<std::string>>();
+		std::shared_ptr<std::vector<PVariable>> immediateValues = std::make_shared<std::vector<PVariable>>();
+		for(size_t i = 0; i < valueKeys->size() && i < values->size(); i++)
+		{
+			if(central->queueEvent(_peerID, channel, valueKeys->at(i), values->at(i))) continue;
+			immediateValueKeys->push_back(valueKeys->at(i));
+			immediateValues->push_back(values->at(i));
+		}
+		if(!immediateValueKeys->empty()) raiseValueEvents(channel, immediateValueKeys, immediateValues);
+	}
+	catch(const std::exception& ex)
+    {
+    	GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+    }
+}
+
 void MyPeer::packetReceived(PMyCulTxPacket& packet)
 {
 	try
@@ -409,6 +679,7 @@ void MyPeer::packetReceived(PMyCulTxPacket& packet)
 			if(!_rpcDevice) return;
 			std::shared_ptr<MyCentral> central = std::dynamic_pointer_cast<MyCentral>(getCentral());
 			if(!central) return;
+			materialize(central.get());
 			setLastPacketReceived();
 			//TODO: RSSI value?
 			//setRssiDevice(packet->getRssi() * -1);
@@ -418,36 +689,49 @@ void MyPeer::packetReceived(PMyCulTxPacket& packet)
 			std::map<uint32_t, std::shared_ptr<std::vector<std::string>>> valueKeys;
 			std::map<uint32_t, std::shared_ptr<std::vector<PVariable>>> rpcValues;
 
-			std::unordered_map<uint32_t, std::unordered_map<std::string, BaseLib::Systems::RpcConfigurationParameter>>::iterator channelIterator;
-			std::unordered_map<std::string, BaseLib::Systems::RpcConfigurationParameter>::iterator parameterIterator;
+			if(!packet->isValid()) return;
 
-			std::string valueKey;
+			HotParameter hotParameter;
 			int32_t channel = 0;
-			std::string payload = packet->getPayload();
+			int32_t value = packet->getValue();
 
-			if(packet->getType() == 0) valueKey = "TEMPERATURE";
-			else if(packet->getType() == 14) valueKey = "HUMIDITY";
+			if(packet->getType() == 0) hotParameter = HotParameter::temperature; //Stored in tenths of a degree (decimalIntegerScale with factor 10)
+			else if(packet->getType() == 14)
+			{
+				hotParameter = HotParameter::humidity; //Stored as integer percentage
+				value /= 10;
+			}
+			else return;
 
-			channelIterator = valuesCentral.find(channel);
-			if(channelIterator == valuesCentral.end()) return;
-			parameterIterator= channelIterator->second.find(valueKey);
-			if(parameterIterator == channelIterator->second.end()) return;
+			const std::string& valueKey = _hotParameterKeys.at((size_t)hotParameter);
+			BaseLib::Systems::RpcConfigurationParameter* parameter = getHotParameter(hotParameter, channel);
+			if(!parameter) return;
 
 			valueKeys[channel].reset(new std::vector<std::string>());
 			rpcValues[channel].reset(new std::vector<PVariable>());
 
-			std::vector<uint8_t> parameterData;
-			parameterIterator->second.rpcParameter->convertToPacket(payload, parameterIterator->second.mainRole(), parameterData);
-			parameterIterator->second.setBinaryData(parameterData);
+			if(!parameter->rpcParameter || !parameter->rpcParameter->physical) return;
 
-			if(parameterIterator->second.databaseId > 0) saveParameter(parameterIterator->second.databaseId, parameterData);
-			else saveParameter(0, ParameterGroup::Type::Enum::variables, channel, valueKey, parameterData);
+			const ChangeDetectionSettings& changeDetectionSettings = central->getChangeDetectionSettings();
+			int32_t deadband = (hotParameter == HotParameter::temperature) ? changeDetectionSettings.temperatureDeadband : changeDetectionSettings.humidityDeadband;
+			if(!isSignificantChange(hotParameter, *parameter, value, deadband, changeDetectionSettings)) return;
+
+			//Physical integer, big endian
+			std::vector<uint8_t> parameterData(std::max((int32_t)std::ceil(parameter->rpcParameter->physical->size), 1));
+			for(int32_t i = parameterData.size() - 1; i >= 0; i--)
+			{
+				parameterData[i] = (uint8_t)(value & 0xFF);
+				value >>= 8;
+			}
+			parameter->setBinaryData(parameterData);
+
+			saveValue(*parameter, channel, valueKey, parameterData);
 			if(_bl->debugLevel >= 4) GD::out.printInfo("Info: " + valueKey + " on channel " + std::to_string(channel) + " of peer " + std::to_string(_peerID) + " with serial number " + _serialNumber  + " was set to 0x" + BaseLib::HelperFunctions::getHexString(parameterData) + ".");
 
-			if(parameterIterator->second.rpcParameter)
+			if(parameter->rpcParameter)
 			{
 				valueKeys[channel]->push_back(valueKey);
-				rpcValues[channel]->push_back(parameterIterator->second.rpcParameter->convertFromPacket(parameterData, parameterIterator->second.mainRole(), true));
+				rpcValues[channel]->push_back(parameter->rpcParameter->convertFromPacket(parameterData, parameter->mainRole(), true));
 			}
 
 			if(!rpcValues.empty())
@@ -455,10 +739,7 @@ void MyPeer::packetReceived(PMyCulTxPacket& packet)
 				for(std::map<uint32_t, std::shared_ptr<std::vector<std::string>>>::iterator j = valueKeys.begin(); j != valueKeys.end(); ++j)
 				{
 					if(j->second->empty()) continue;
-					std::string address(_serialNumber + ":" + std::to_string(j->first));
-	                std::string eventSource = "device-" + std::to_string(_peerID);
-	                raiseEvent(eventSource, _peerID, j->first, j->second, rpcValues.at(j->first));
-	                raiseRPCEvent(eventSource, _peerID, j->first, address, j->second, rpcValues.at(j->first));
+					publishValueEvents(central, j->first, j->second, rpcValues.at(j->first));
 				}
 			}
 		}
@@ -481,6 +762,7 @@ void MyPeer::packetReceived(PMyPacket& packet)
 		if(!_rpcDevice) return;
 		std::shared_ptr<MyCentral> central = std::dynamic_pointer_cast<MyCentral>(getCentral());
 		if(!central) return;
+		materialize(central.get());
 		setLastPacketReceived();
 		setRssiDevice(packet->getRssi() * -1);
 		serviceMessages->endUnreach();
@@ -488,38 +770,38 @@ void MyPeer::packetReceived(PMyPacket& packet)
 		std::map<uint32_t, std::shared_ptr<std::vector<std::string>>> valueKeys;
 		std::map<uint32_t, std::shared_ptr<std::vector<PVariable>>> rpcValues;
 
-		std::unordered_map<uint32_t, std::unordered_map<std::string, BaseLib::Systems::RpcConfigurationParameter>>::iterator channelIterator;
-		std::unordered_map<std::string, BaseLib::Systems::RpcConfigurationParameter>::iterator parameterIterator;
-
-		std::string valueKey;
+		HotParameter hotParameter;
 		int32_t channel = 0;
-		std::string payload = packet->getPayload();
+		const MyPacket::Command& command = packet->getCommand();
+		if(!command.valid) return;
 
-		if(payload.at(0) == '1') valueKey = "GROUP_STATE";
+		if(command.isGroup()) hotParameter = HotParameter::groupState;
 		else
 		{
-			valueKey = "STATE";
-			channel = valuesCentral.find(2) != valuesCentral.end() ? packet->getChannel() : 1; //At least two channels in device description?
+			hotParameter = HotParameter::state;
+			channel = _multiChannel ? packet->getChannel() : 1;
 		}
 
-		channelIterator = valuesCentral.find(channel);
-		if(channelIterator == valuesCentral.end()) return;
-		parameterIterator= channelIterator->second.find(valueKey);
-		if(parameterIterator == channelIterator->second.end()) return;
+		const std::string& valueKey = _hotParameterKeys.at((size_t)hotParameter);
+		BaseLib::Systems::RpcConfigurationParameter* parameter = getHotParameter(hotParameter, channel);
+		if(!parameter) return;
 
 		valueKeys[channel].reset(new std::vector<std::string>());
 		rpcValues[channel].reset(new std::vector<PVariable>());
 
-		std::vector<uint8_t> parameterData = (payload.at(1) == '0') ? std::vector<uint8_t>{ 0 } : std::vector<uint8_t>{ 1 };
-		parameterIterator->second.setBinaryData(parameterData);
-		if(parameterIterator->second.databaseId > 0) saveParameter(parameterIterator->second.databaseId, parameterData);
-		else saveParameter(0, ParameterGroup::Type::Enum::variables, channel, valueKey, parameterData);
+		std::vector<uint8_t> parameterData{ (uint8_t)(command.isOn() ? 1 : 0) };
+		//Pressing the same button again is still raised as event, but the unchanged value doesn't need to be saved.
+		if(!parameter->equals(parameterData))
+		{
+			parameter->setBinaryData(parameterData);
+			saveValue(*parameter, channel, valueKey, parameterData);
+		}
 		if(_bl->debugLevel >= 4) GD::out.printInfo("Info: " + valueKey + " on channel " + std::to_string(channel) + " of peer " + std::to_string(_peerID) + " with serial number " + _serialNumber  + " was set to 0x" + BaseLib::HelperFunctions::getHexString(parameterData) + ".");
 
-		if(parameterIterator->second.rpcParameter)
+		if(parameter->rpcParameter)
 		{
 			valueKeys[channel]->push_back(valueKey);
-			rpcValues[channel]->push_back(parameterIterator->second.rpcParameter->convertFromPacket(parameterData, parameterIterator->second.mainRole(), true));
+			rpcValues[channel]->push_back(parameter->rpcParameter->convertFromPacket(parameterData, parameter->mainRole(), true));
 		}
 
 		if(!rpcValues.empty())
@@ -527,10 +809,7 @@ void MyPeer::packetReceived(PMyPacket& packet)
 			for(std::map<uint32_t, std::shared_ptr<std::vector<std::string>>>::iterator j = valueKeys.begin(); j != valueKeys.end(); ++j)
 			{
 				if(j->second->empty()) continue;
-				std::string address(_serialNumber + ":" + std::to_string(j->first));
-                std::string eventSource = "device-" + std::to_string(_peerID);
-                raiseEvent(eventSource, _peerID, j->first, j->second, rpcValues.at(j->first));
-                raiseRPCEvent(eventSource, _peerID, j->first, address, j->second, rpcValues.at(j->first));
+				publishValueEvents(central, j->first, j->second, rpcValues.at(j->first));
 			}
 		}
 	}
@@ -600,11 +879,36 @@ bool MyPeer::getParamsetHook2(PRpcClientInfo clientInfo, PParameter parameter, u
     return false;
 }
 
+PVariable MyPeer::getAllValues(BaseLib::PRpcClientInfo clientInfo, bool returnWriteOnly, bool checkAcls)
+{
+	materialize();
+	return Peer::getAllValues(clientInfo, returnWriteOnly, checkAcls);
+}
+
+PVariable MyPeer::getParamset(BaseLib::PRpcClientInfo clientInfo, int32_t channel, ParameterGroup::Type::Enum type, uint64_t remoteID, int32_t remoteChannel, bool checkAcls)
+{
+	materialize();
+	return Peer::getParamset(clientInfo, channel, type, remoteID, remoteChannel, checkAcls);
+}
+
+PVariable MyPeer::getValue(BaseLib::PRpcClientInfo clientInfo, uint32_t channel, std::string valueKey, bool requestFromDevice, bool asynchronous)
+{
+	materialize();
+	return Peer::getValue(clientInfo, channel, valueKey, requestFromDevice, asynchronous);
+}
+
+PArray MyPeer::getDeviceDescriptions(BaseLib::PRpcClientInfo clientInfo, bool channels, std::map<std::string, bool> fields)
+{
+	materialize();
+	return Peer::getDeviceDescriptions(clientInfo, channels, fields);
+}
+
 PVariable MyPeer::putParamset(BaseLib::PRpcClientInfo clientInfo, int32_t channel, ParameterGroup::Type::Enum type, uint64_t remoteID, int32_t remoteChannel, PVariable variables, bool checkAcls, bool onlyPushing)
 {
 	try
 	{
 		if(_disposing) return Variable::createError(-32500, "Peer is disposing.");
+		materialize();
 		if(channel < 0) channel = 0;
 		if(remoteChannel < 0) remoteChannel = 0;
 		Functions::iterator functionIterator = _rpcDevice->functions.find(channel);
@@ -634,6 +938,7 @@ PVariable MyPeer::putParamset(BaseLib::PRpcClientInfo clientInfo, int32_t channe
 				else saveParameter(0, ParameterGroup::Type::Enum::config, channel, i->first, parameterData);
 
 				parameterChanged = true;
+				setDirty();
 				GD::out.printInfo("Info: Parameter " + i->first + " of peer " + std::to_string(_peerID) + " and channel " + std::to_string(channel) + " was set to 0x" + BaseLib::HelperFunctions::getHexString(parameterData) + ".");
 			}
 
@@ -682,10 +987,145 @@ PVariable MyPeer::setInterface(BaseLib::PRpcClientInfo clientInfo, std::string i
     return Variable::createError(-32500, "Unknown application error.");
 }
 
+PMyPacket MyPeer::createPacket(BaseLib::Systems::RpcConfigurationParameter& parameter, uint32_t channel, const std::string& valueKey, bool value, IIntertechnoInterface::TxPriority& priority, uint64_t& coalescingKey)
+{
+	try
+	{
+		PMyPacket packet;
+		//Queued STATE and GROUP_STATE packets not sent yet are replaced by newer ones
+		if(&parameter == getHotParameter(HotParameter::state, channel))
+		{
+			coalescingKey = getCoalescingKey(HotParameter::state, channel);
+			std::string payload;
+			if(getDeviceType() == 2) //REV Ritter
+			{
+				//Manually create packet
+				std::string packetString;
+				packetString.reserve(12);
+				for(int32_t i = 9; i >= 0; i--)
+				{
+					if(i == 2) packetString.push_back('0');
+					else packetString.push_back(_address & (1 << i) ? 'F' : '1');
+				}
+				payload = value ? "FF" : "00";
+				packetString.insert(packetString.end(), payload.begin(), payload.end());
+				packet.reset(new MyPacket());
+				packet->setPacket(packetString);
+			}
+			else
+			{
+				if(value) payload = (_address & 0xFFFFFC00) ? "01" : "FF";
+				else payload = (_address & 0xFFFFFC00) ? "00" : "F0";
+				packet.reset(new MyPacket(_address, payload));
+			}
+		}
+		if(&parameter == getHotParameter(HotParameter::groupState, channel))
+		{
+			coalescingKey = getCoalescingKey(HotParameter::groupState, channel);
+			std::string payload;
+			if(value) payload = (_address & 0xFFFFFC00) ? "11" : "FF";
+			else payload = (_address & 0xFFFFFC00) ? "10" : "F0";
+			packet.reset(new MyPacket(_address, payload));
+		}
+		else if(valueKey == "PAIRING")
+		{
+			std::string payload = (_address & 0xFFFFFC00) ? "01" : "FF";
+			packet.reset(new MyPacket(_address, payload));
+			priority = IIntertechnoInterface::TxPriority::high; //The device only stays in learning mode for a few seconds
+		}
+		else if(valueKey == "UNPAIRING")
+		{
+			std::string payload = (_address & 0xFFFFFC00) ? "00" : "F0";
+			packet.reset(new MyPacket(_address, payload));
+			priority = IIntertechnoInterface::TxPriority::high;
+		}
+		return packet;
+	}
+	catch(const std::exception& ex)
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+	return PMyPacket();
+}
+
+std::shared_future<bool> MyPeer::queuePacket(const PMyPacket& packet, IIntertechnoInterface::TxPriority priority, uint64_t coalescingKey)
+{
+	try
+	{
+		std::shared_ptr<IIntertechnoInterface> interface = _physicalInterface;
+		std::shared_ptr<MyCentral> central = std::dynamic_pointer_cast<MyCentral>(getCentral());
+		if(central) interface = central->selectTxInterface(_physicalInterface, _linkQuality, packet, priority, coalescingKey);
+		if(interface) return interface->queuePacket(packet, priority, coalescingKey);
+		GD::out.printError("Error: Peer " + std::to_string(_peerID) + " has no interface to send packets with.");
+	}
+	catch(const std::exception& ex)
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+	std::promise<bool> notSent;
+	notSent.set_value(false);
+	return notSent.get_future().share();
+}
+
+bool MyPeer::canSetState(uint32_t channel, bool group)
+{
+	if(_disposing) return false;
+	materialize();
+	BaseLib::Systems::RpcConfigurationParameter* parameter = getHotParameter(group ? HotParameter::groupState : HotParameter::state, channel);
+	return parameter && parameter->rpcParameter;
+}
+
+PVariable MyPeer::setState(BaseLib::PRpcClientInfo clientInfo, uint32_t channel, bool group, bool value, bool send, std::shared_future<bool>& sent)
+{
+	try
+	{
+		if(_disposing) return Variable::createError(-32500, "Peer is disposing.");
+		materialize();
+		HotParameter hotParameter = group ? HotParameter::groupState : HotParameter::state;
+		const std::string& valueKey = _hotParameterKeys.at((size_t)hotParameter);
+		BaseLib::Systems::RpcConfigurationParameter* parameter = getHotParameter(hotParameter, channel);
+		if(!parameter) return Variable::createError(-5, "Unknown parameter.");
+		PParameter rpcParameter = parameter->rpcParameter;
+
+		PVariable variable = std::make_shared<Variable>(value);
+		std::vector<uint8_t> parameterData;
+		rpcParameter->convertToPacket(variable, parameter->mainRole(), parameterData);
+		parameter->setBinaryData(parameterData);
+		saveValue(*parameter, channel, valueKey, parameterData);
+		if(_bl->debugLevel >= 4) GD::out.printInfo("Info: " + valueKey + " of peer " + std::to_string(_peerID) + " with serial number " + _serialNumber + ":" + std::to_string(channel) + " was set to 0x" + BaseLib::HelperFunctions::getHexString(parameterData) + (send ? "." : " without sending a packet."));
+
+		if(send)
+		{
+			IIntertechnoInterface::TxPriority priority = IIntertechnoInterface::TxPriority::normal;
+			uint64_t coalescingKey = 0;
+			PMyPacket packet = createPacket(*parameter, channel, valueKey, value, priority, coalescingKey);
+			if(!packet) return Variable::createError(-32500, "Could not create packet.");
+			sent = queuePacket(packet, priority, coalescingKey);
+		}
+
+		if(rpcParameter->readable)
+		{
+			std::shared_ptr<std::vector<std::string>> valueKeys = std::make_shared<std::vector<std::string>>(1, valueKey);
+			std::shared_ptr<std::vector<PVariable>> values = std::make_shared<std::vector<PVariable>>(1, variable);
+			std::string address = getChannelAddress(channel);
+			raiseEvent(clientInfo->initInterfaceId, _peerID, channel, valueKeys, values);
+			raiseRPCEvent(clientInfo->initInterfaceId, _peerID, channel, address, valueKeys, values);
+		}
+
+		return PVariable(new Variable(VariableType::tVoid));
+	}
+	catch(const std::exception& ex)
+	{
+		GD::out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+	return Variable::createError(-32500, "Unknown application error. See error log for more details.");
+}
+
 PVariable MyPeer::setValue(BaseLib::PRpcClientInfo clientInfo, uint32_t channel, std::string valueKey, PVariable value, bool wait)
 {
 	try
 	{
+		materialize();
 		Peer::setValue(clientInfo, channel, valueKey, value, wait); //Ignore result, otherwise setHomegerValue might not be executed
 		if(_disposing) return Variable::createError(-32500, "Peer is disposing.");
 		std::shared_ptr<MyCentral> central = std::dynamic_pointer_cast<MyCentral>(getCentral());
@@ -695,10 +1135,10 @@ PVariable MyPeer::setValue(BaseLib::PRpcClientInfo clientInfo, uint32_t channel,
 		std::unordered_map<uint32_t, std::unordered_map<std::string, BaseLib::Systems::RpcConfigurationParameter>>::iterator channelIterator = valuesCentral.find(channel);
 		if(channelIterator == valuesCentral.end()) return Variable::createError(-2, "Unknown channel.");
 		std::unordered_map<std::string, BaseLib::Systems::RpcConfigurationParameter>::iterator parameterIterator = channelIterator->second.find(valueKey);
-		if(parameterIterator == valuesCentral[channel].end()) return Variable::createError(-5, "Unknown parameter.");
+		if(parameterIterator == channelIterator->second.end()) return Variable::createError(-5, "Unknown parameter.");
 		PParameter rpcParameter = parameterIterator->second.rpcParameter;
 		if(!rpcParameter) return Variable::createError(-5, "Unknown parameter.");
-		BaseLib::Systems::RpcConfigurationParameter& parameter = valuesCentral[channel][valueKey];
+		BaseLib::Systems::RpcConfigurationParameter& parameter = parameterIterator->second;
 		std::shared_ptr<std::vector<std::string>> valueKeys(new std::vector<std::string>());
 		std::shared_ptr<std::vector<PVariable>> values(new std::vector<PVariable>());
 		if(rpcParameter->readable)
@@ -711,11 +1151,10 @@ PVariable MyPeer::setValue(BaseLib::PRpcClientInfo clientInfo, uint32_t channel,
 			std::vector<uint8_t> parameterData;
 			rpcParameter->convertToPacket(value, parameter.mainRole(), parameterData);
 			parameter.setBinaryData(parameterData);
-			if(parameter.databaseId > 0) saveParameter(parameter.databaseId, parameterData);
-			else saveParameter(0, ParameterGroup::Type::Enum::variables, channel, valueKey, parameterData);
+			saveValue(parameter, channel, valueKey, parameterData);
 			if(!valueKeys->empty())
 			{
-                std::string address(_serialNumber + ":" + std::to_string(channel));
+                std::string address = getChannelAddress(channel);
                 raiseEvent(clientInfo->initInterfaceId, _peerID, channel, valueKeys, values);
                 raiseRPCEvent(clientInfo->initInterfaceId, _peerID, channel, address, valueKeys, values);
 			}
@@ -726,60 +1165,25 @@ PVariable MyPeer::setValue(BaseLib::PRpcClientInfo clientInfo, uint32_t channel,
 		std::vector<uint8_t> parameterData;
 		rpcParameter->convertToPacket(value, parameter.mainRole(), parameterData);
 		parameter.setBinaryData(parameterData);
-		if(parameter.databaseId > 0) saveParameter(parameter.databaseId, parameterData);
-		else saveParameter(0, ParameterGroup::Type::Enum::variables, channel, valueKey, parameterData);
+		saveValue(parameter, channel, valueKey, parameterData);
 		if(_bl->debugLevel >= 4) GD::out.printInfo("Info: " + valueKey + " of peer " + std::to_string(_peerID) + " with serial number " + _serialNumber + ":" + std::to_string(channel) + " was set to 0x" + BaseLib::HelperFunctions::getHexString(parameterData) + ".");
 		value = rpcParameter->convertFromPacket(parameterData, parameter.mainRole(), false);
 
-		PMyPacket packet;
-		if(valueKey == "STATE")
-		{
-			std::string payload;
-			if(getDeviceType() == 2) //REV Ritter
-			{
-				//Manually create packet
-				std::string packetString;
-				packetString.reserve(12);
-				for(int32_t i = 9; i >= 0; i--)
-				{
-					if(i == 2) packetString.push_back('0');
-					else packetString.push_back(_address & (1 << i) ? 'F' : '1');
-				}
-				payload = value->booleanValue ? "FF" : "00";
-				packetString.insert(packetString.end(), payload.begin(), payload.end());
-				packet.reset(new MyPacket());
-				packet->setPacket(packetString);
-			}
-			else
-			{
-				if(value->booleanValue) payload = (_address & 0xFFFFFC00) ? "01" : "FF";
-				else payload = (_address & 0xFFFFFC00) ? "00" : "F0";
-				packet.reset(new MyPacket(_address, payload));
-			}
-		}
-		if(valueKey == "GROUP_STATE")
+		IIntertechnoInterface::TxPriority priority = IIntertechnoInterface::TxPriority::normal;
+		uint64_t coalescingKey = 0;
+		PMyPacket packet = createPacket(parameter, channel, valueKey, value->booleanValue, priority, coalescingKey);
+		if(packet)
 		{
-			std::string payload;
-			if(value->booleanValue) payload = (_address & 0xFFFFFC00) ? "11" : "FF";
-			else payload = (_address & 0xFFFFFC00) ? "10" : "F0";
-			packet.reset(new MyPacket(_address, payload));
+			//Returns immediately for interfaces with TX queue. Only when enabled with "setValueWaitTime", "wait" blocks until the
+			//packet was sent. A packet still queued after the wait time (e. g. deferred because of the duty cycle) is not an error.
+			std::shared_future<bool> sent = queuePacket(packet, priority, coalescingKey);
+			int32_t waitTime = wait ? central->getSetValueWaitTime() : 0;
+			if(waitTime > 0 && sent.wait_for(std::chrono::seconds(waitTime)) == std::future_status::ready && !sent.get()) return Variable::createError(-32500, "Packet could not be sent.");
 		}
-		else if(valueKey == "PAIRING")
-		{
-			std::string payload = (_address & 0xFFFFFC00) ? "01" : "FF";
-			packet.reset(new MyPacket(_address, payload));
-		}
-		else if(valueKey == "UNPAIRING")
-		{
-			std::string payload = (_address & 0xFFFFFC00) ? "00" : "F0";
-			packet.reset(new MyPacket(_address, payload));
-		}
-
-		if(packet) _physicalInterface->sendPacket(packet);
 
 		if(!valueKeys->empty())
 		{
-            std::string address(_serialNumber + ":" + std::to_string(channel));
+            std::string address = getChannelAddress(channel);
             raiseEvent(clientInfo->initInterfaceId, _peerID, channel, valueKeys, values);
             raiseRPCEvent(clientInfo->initInterfaceId, _peerID, channel, address, valueKeys, values);
 		}
@@ -35,9 +35,17 @@
 #include "MyPacket.h"
 #include <homegear-base/BaseLib.h>
 
+#include "LinkQuality.h"
 #include "MyCulTxPacket.h"
+#include "PeerStateFile.h"
 #include "PhysicalInterfaces/IIntertechnoInterface.h"
 
+#include <array>
+#include <atomic>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+
 using namespace BaseLib;
 using namespace BaseLib::DeviceDescription;
 
@@ -45,6 +53,17 @@ namespace MyFamily
 {
 class MyCentral;
 
+/**
+ * Settings of the change detection for sensor values (see MyPeer::isSignificantChange()).
+ */
+struct ChangeDetectionSettings
+{
+	int32_t temperatureDeadband = 0; //In tenths of a degree
+	int32_t humidityDeadband = 0; //In percent
+	int32_t relativeDeadband = 0; //In percent of the current value
+	int32_t heartbeat = 900; //In seconds. Unchanged values are reported at least this often. 0 disables the heartbeat.
+};
+
 class MyPeer : public BaseLib::Systems::Peer, public BaseLib::Rpc::IWebserverEventSink
 {
 public:
@@ -65,11 +84,68 @@ public:
 
 	std::shared_ptr<IIntertechnoInterface>& getPhysicalInterface() { return _physicalInterface; }
 
+	/**
+	 * Link statistics per receiving interface. Updated by the central for every frame received from this peer.
+	 */
+	LinkQuality& getLinkQuality() { return _linkQuality; }
+
 	virtual std::string handleCliCommand(std::string command);
 	void packetReceived(PMyPacket& packet);
 	void packetReceived(PMyCulTxPacket& packet);
 
 	virtual bool load(BaseLib::Systems::ICentral* central);
+
+	/**
+	 * {@inheritDoc}
+	 */
+	virtual void initializeCentralConfig();
+
+	//{{{ Lazy loading
+	/**
+	 * Loads only what is needed to find and list the peer: the peer variables (interface, device type and device description).
+	 * configCentral, valuesCentral and the service messages are loaded by materialize().
+	 */
+	bool loadIndex(BaseLib::Systems::ICentral* central);
+
+	/**
+	 * Same as loadIndex(ICentral*), but takes the index data from the peer state file instead of the database. The remaining
+	 * peer variables are loaded by materialize().
+	 */
+	bool loadIndex(const PeerStateFile::PeerEntry& entry);
+
+	/**
+	 * Returns the index data to store in the peer state file.
+	 */
+	PeerStateFile::PeerEntry getIndexEntry();
+
+	/**
+	 * Loads the configuration, values and service messages if not done yet. Called on the first received packet and when the
+	 * peer is requested through MyCentral::getPeer(). Thread safe.
+	 */
+	void materialize(BaseLib::Systems::ICentral* central);
+
+	bool isMaterialized() { return _materialized; }
+
+	/**
+	 * Materializes the peer using its own central. RPC methods get the peer through ICentral and not through
+	 * MyCentral::getPeer(), so they call this before accessing configCentral or valuesCentral.
+	 */
+	void materialize();
+	//}}}
+
+	//{{{ Dirty tracking
+	/**
+	 * Marks the peer as changed since the last MyCentral::savePeers().
+	 */
+	void setDirty() { _dirty = true; }
+
+	/**
+	 * Resets the dirty flag.
+	 *
+	 * @return Returns true when the peer was dirty.
+	 */
+	bool resetDirty() { return _dirty.exchange(false); }
+	//}}}
     virtual void savePeers() {}
 
 	virtual int32_t getChannelGroupedWith(int32_t channel) { return -1; }
@@ -79,6 +155,34 @@ public:
 
     std::string printConfig();
 
+    /**
+     * Writes all values changed since the last call to the database. Called by the central's write-behind thread.
+     *
+     * @return Returns the number of values written.
+     */
+    uint32_t saveDirtyValues();
+
+    /**
+     * Raises one event and one RPC event for the values of a channel. Called directly or by the central's event batching thread.
+     */
+    void raiseValueEvents(int32_t channel, std::shared_ptr<std::vector<std::string>>& valueKeys, std::shared_ptr<std::vector<PVariable>>& values);
+
+    //{{{ Scenes
+    /**
+     * Returns true when setState() can set STATE or GROUP_STATE of the channel.
+     */
+    bool canSetState(uint32_t channel, bool group);
+
+    /**
+     * Sets STATE or GROUP_STATE like setValue(), but returns without waiting for the packet. Used by MyCentral::setScene().
+     *
+     * @param send When false, only the value is saved and raised, because the device is switched by a packet sent for another
+     * target.
+     * @param[out] sent The future of the queued packet. Only valid when a packet was queued.
+     */
+    PVariable setState(BaseLib::PRpcClientInfo clientInfo, uint32_t channel, bool group, bool value, bool send, std::shared_future<bool>& sent);
+    //}}}
+
     /**
 	 * {@inheritDoc}
 	 */
@@ -93,6 +197,12 @@ public:
 	virtual PVariable putParamset(BaseLib::PRpcClientInfo clientInfo, int32_t channel, ParameterGroup::Type::Enum type, uint64_t remoteID, int32_t remoteChannel, PVariable variables, bool checkAcls, bool onlyPushing = false);
 	PVariable setInterface(BaseLib::PRpcClientInfo clientInfo, std::string interfaceId);
 	virtual PVariable setValue(BaseLib::PRpcClientInfo clientInfo, uint32_t channel, std::string valueKey, PVariable value, bool wait);
+
+	//The following methods only materialize the peer and call the base class implementation.
+	virtual PVariable getAllValues(BaseLib::PRpcClientInfo clientInfo, bool returnWriteOnly, bool checkAcls);
+	virtual PVariable getParamset(BaseLib::PRpcClientInfo clientInfo, int32_t channel, ParameterGroup::Type::Enum type, uint64_t remoteID, int32_t remoteChannel, bool checkAcls);
+	virtual PVariable getValue(BaseLib::PRpcClientInfo clientInfo, uint32_t channel, std::string valueKey, bool requestFromDevice, bool asynchronous);
+	virtual PArray getDeviceDescriptions(BaseLib::PRpcClientInfo clientInfo, bool channels, std::map<std::string, bool> fields);
 	//End RPC methods
 protected:
 	//In table variables:
@@ -100,8 +210,91 @@ protected:
 	//End
 
 	bool _shuttingDown = false;
+	std::atomic_bool _materialized{false};
+	std::mutex _materializeMutex;
+	bool _variablesLoaded = false;
+	std::atomic_bool _dirty{false};
 	std::shared_ptr<IIntertechnoInterface> _physicalInterface;
 	uint32_t _lastRssiDevice = 0;
+	LinkQuality _linkQuality;
+
+	//{{{ Hot parameters
+	/**
+	 * Values used by the receive path and setValue. initializeHotParameters() resolves them once to pointers into valuesCentral,
+	 * indexed by key and channel, so the value keys don't need to be hashed for every packet. valuesCentral is not modified
+	 * after initializeCentralConfig(), so the pointers stay valid. The event source and the channel addresses are built at
+	 * the same time.
+	 */
+	enum class HotParameter : int32_t
+	{
+		state,
+		groupState,
+		rssiDevice,
+		temperature,
+		humidity,
+		count
+	};
+
+	static const std::array<std::string, (size_t)HotParameter::count> _hotParameterKeys;
+	static const uint32_t _maxHotParameterChannels = 64; //Higher channels are not cached
+
+	std::array<std::vector<BaseLib::Systems::RpcConfigurationParameter*>, (size_t)HotParameter::count> _hotParameters;
+	bool _multiChannel = false;
+	std::string _eventSource;
+	std::vector<std::string> _channelAddresses; //"<serial number>:<channel>"
+
+	void initializeHotParameters();
+	BaseLib::Systems::RpcConfigurationParameter* getHotParameter(HotParameter parameter, uint32_t channel);
+	std::string getChannelAddress(uint32_t channel);
+
+	/**
+	 * Returns the key identifying packets setting the same value (see IIntertechnoInterface::queuePacket()).
+	 */
+	uint64_t getCoalescingKey(HotParameter parameter, uint32_t channel);
+	//}}}
+
+	/**
+	 * Creates the packet setting STATE or GROUP_STATE of the channel, PAIRING or UNPAIRING. Returns nullptr for other
+	 * parameters.
+	 */
+	PMyPacket createPacket(BaseLib::Systems::RpcConfigurationParameter& parameter, uint32_t channel, const std::string& valueKey, bool value, IIntertechnoInterface::TxPriority& priority, uint64_t& coalescingKey);
+
+	/**
+	 * Queues the packet on the interface returned by MyCentral::selectTxInterface().
+	 */
+	std::shared_future<bool> queuePacket(const PMyPacket& packet, IIntertechnoInterface::TxPriority priority, uint64_t coalescingKey);
+
+	//{{{ Change detection
+	std::array<int64_t, (size_t)HotParameter::count> _lastValueReport{}; //In milliseconds. Sensor values are only received on channel 0.
+
+	/**
+	 * Compares a received sensor value with the current value of the parameter. Returns true when the value needs to be saved
+	 * and raised: either the difference exceeds the absolute and the relative deadband or no value was reported for longer than
+	 * the heartbeat interval.
+	 */
+	bool isSignificantChange(HotParameter hotParameter, BaseLib::Systems::RpcConfigurationParameter& parameter, int32_t value, int32_t deadband, const ChangeDetectionSettings& settings);
+	//}}}
+
+	//{{{ Write-behind
+	/**
+	 * Copy of a changed value taken by saveValue(). saveDirtyValues() runs on the central's write-behind thread and only uses
+	 * these copies, so it never reads valuesCentral while the value is changed.
+	 */
+	struct DirtyValue
+	{
+		uint64_t databaseId = 0;
+		std::vector<uint8_t> data;
+	};
+
+	std::mutex _dirtyValuesMutex;
+	std::map<std::pair<uint32_t, std::string>, DirtyValue> _dirtyValues;
+
+	/**
+	 * Saves a parameter of the "variables" parameter group. When write-behind is enabled, the value is only marked dirty and
+	 * written later by the central. A pending value of the same parameter is replaced.
+	 */
+	void saveValue(BaseLib::Systems::RpcConfigurationParameter& parameter, uint32_t channel, const std::string& valueKey, std::vector<uint8_t>& parameterData);
+	//}}}
 
 	virtual void loadVariables(BaseLib::Systems::ICentral* central, std::shared_ptr<BaseLib::Database::DataTable>& rows);
     virtual void saveVariables();
@@ -109,6 +302,12 @@ protected:
     virtual void setPhysicalInterface(std::shared_ptr<IIntertechnoInterface> interface);
     void setRssiDevice(uint8_t rssi);
 
+    /**
+     * Hands the values of a received packet to the central's event batcher. Values of keys excluded from batching, or all values
+     * when batching is disabled, are raised immediately.
+     */
+    void publishValueEvents(const std::shared_ptr<MyCentral>& central, int32_t channel, std::shared_ptr<std::vector<std::string>>& valueKeys, std::shared_ptr<std::vector<PVariable>>& values);
+
 	virtual std::shared_ptr<BaseLib::Systems::ICentral> getCentral();
 
 	virtual PParameterGroup getParameterSet(int32_t channel, ParameterGroup::Type::Enum type);
@@ -0,0 +1,135 @@
+/* Copyright 2013-2019 Homegear GmbH
+ *
+ * Homegear is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Homegear is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Homegear.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "PacketQueue.h"
+
+#include <chrono>
+
+namespace MyFamily
+{
+
+PacketQueue::PacketQueue(uint32_t capacity, OverflowPolicy overflowPolicy) : _overflowPolicy(overflowPolicy)
+{
+	if(capacity == 0) capacity = 1;
+	_buffer.resize(capacity);
+	_statistics.capacity = capacity;
+}
+
+PacketQueue::~PacketQueue()
+{
+	stop();
+}
+
+PacketQueue::OverflowPolicy PacketQueue::parseOverflowPolicy(std::string value)
+{
+	BaseLib::HelperFunctions::toLower(value);
+	if(value == "block") return OverflowPolicy::block;
+	else if(value == "dropnewest") return OverflowPolicy::dropNewest;
+	return OverflowPolicy::dropOldest;
+}
+
+int64_t PacketQueue::getTimeMicroseconds()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool PacketQueue::push(Entry& entry)
+{
+	std::unique_lock<std::mutex> queueGuard(_queueMutex);
+	if(_stopped) return false;
+	if(_size == _buffer.size())
+	{
+		if(_overflowPolicy == OverflowPolicy::block)
+		{
+			_notFullConditionVariable.wait(queueGuard, [&] { return _stopped || _size < _buffer.size(); });
+			if(_stopped) return false;
+		}
+		else if(_overflowPolicy == OverflowPolicy::dropOldest)
+		{
+			_buffer[_head] = Entry();
+			_head = (_head + 1) % _buffer.size();
+			_size--;
+			_statistics.dropped++;
+		}
+		else
+		{
+			_statistics.dropped++;
+			return false;
+		}
+	}
+
+	entry.enqueueTime = getTimeMicroseconds();
+	_buffer[(_head + _size) % _buffer.size()] = std::move(entry);
+	_size++;
+	_statistics.enqueued++;
+	if(_size > _statistics.maxDepth) _statistics.maxDepth = _size;
+	queueGuard.unlock();
+	_notEmptyConditionVariable.notify_one();
+	return true;
+}
+
+bool PacketQueue::pop(Entry& entry)
+{
+	std::unique_lock<std::mutex> queueGuard(_queueMutex);
+	_notEmptyConditionVariable.wait(queueGuard, [&] { return _stopped || _size > 0; });
+	if(_stopped) return false;
+
+	entry = std::move(_buffer[_head]);
+	_buffer[_head] = Entry();
+	_head = (_head + 1) % _buffer.size();
+	_size--;
+
+	int64_t waitTime = getTimeMicroseconds() - entry.enqueueTime;
+	_statistics.processed++;
+	_statistics.totalWaitTime += waitTime;
+	if(waitTime > _statistics.maxWaitTime) _statistics.maxWaitTime = waitTime;
+	queueGuard.unlock();
+	_notFullConditionVariable.notify_one();
+	return true;
+}
+
+void PacketQueue::stop()
+{
+	{
+		std::lock_guard<std::mutex> queueGuard(_queueMutex);
+		_stopped = true;
+	}
+	_notEmptyConditionVariable.notify_all();
+	_notFullConditionVariable.notify_all();
+}
+
+PacketQueue::Statistics PacketQueue::getStatistics()
+{
+	std::lock_guard<std::mutex> queueGuard(_queueMutex);
+	Statistics statistics = _statistics;
+	statistics.depth = _size;
+	return statistics;
+}
+
+}
@@ -0,0 +1,124 @@
+/* Copyright 2013-2019 Homegear GmbH
+ *
+ * Homegear is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Homegear is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Homegear.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef PACKETQUEUE_H_
+#define PACKETQUEUE_H_
+
+#include <cstdint>
+
+#include <homegear-base/BaseLib.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace MyFamily
+{
+
+/**
+ * Bounded ring buffer used to hand received packets from the interface threads to the central's dispatch threads.
+ */
+class PacketQueue
+{
+public:
+	enum class OverflowPolicy
+	{
+		dropOldest,
+		block,
+		dropNewest
+	};
+
+	struct Entry
+	{
+		std::string senderId;
+		std::shared_ptr<BaseLib::Systems::Peer> peer;
+		std::shared_ptr<BaseLib::Systems::Packet> packet;
+		int64_t enqueueTime = 0;
+	};
+
+	struct Statistics
+	{
+		uint32_t capacity = 0;
+		uint32_t depth = 0;
+		uint32_t maxDepth = 0;
+		uint64_t enqueued = 0;
+		uint64_t processed = 0;
+		uint64_t dropped = 0;
+		int64_t totalWaitTime = 0; //In microseconds
+		int64_t maxWaitTime = 0; //In microseconds
+	};
+
+	PacketQueue(uint32_t capacity, OverflowPolicy overflowPolicy);
+	virtual ~PacketQueue();
+
+	/**
+	 * Converts the value of the setting "receiveQueueFullPolicy" ("dropOldest", "block" or "dropNewest") to an OverflowPolicy.
+	 */
+	static OverflowPolicy parseOverflowPolicy(std::string value);
+
+	/**
+	 * Adds an entry to the queue. What happens when the queue is full depends on the overflow policy.
+	 *
+	 * @param entry The entry to add. The content is moved into the queue.
+	 * @return Returns false when the entry was dropped.
+	 */
+	bool push(Entry& entry);
+
+	/**
+	 * Removes the oldest entry from the queue. Blocks until an entry is available or stop() is called.
+	 *
+	 * @param[out] entry The removed entry.
+	 * @return Returns false when the queue was stopped.
+	 */
+	bool pop(Entry& entry);
+
+	/**
+	 * Wakes up all waiting threads. After calling stop() push() and pop() return false.
+	 */
+	void stop();
+
+	Statistics getStatistics();
+protected:
+	OverflowPolicy _overflowPolicy = OverflowPolicy::dropOldest;
+	std::mutex _queueMutex;
+	std::condition_variable _notEmptyConditionVariable;
+	std::condition_variable _notFullConditionVariable;
+	std::vector<Entry> _buffer;
+	uint32_t _head = 0;
+	uint32_t _size = 0;
+	bool _stopped = false;
+	Statistics _statistics;
+
+	static int64_t getTimeMicroseconds();
+};
+
+}
+
+#endif
@@ -0,0 +1,181 @@
+/* Copyright 2013-2019 Homegear GmbH
+ *
+ * Homegear is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Homegear is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Homegear.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "PeerStateFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace MyFamily
+{
+
+namespace
+{
+
+template<typename T> void append(std::vector<uint8_t>& buffer, T value)
+{
+	const uint8_t* data = reinterpret_cast<const uint8_t*>(&value);
+	buffer.insert(buffer.end(), data, data + sizeof(T));
+}
+
+void appendString(std::vector<uint8_t>& buffer, const std::string& value)
+{
+	append<uint16_t>(buffer, (uint16_t)value.size());
+	buffer.insert(buffer.end(), value.begin(), value.begin() + (uint16_t)value.size());
+}
+
+template<typename T> bool take(const uint8_t*& position, const uint8_t* end, T& value)
+{
+	if((size_t)(end - position) < sizeof(T)) return false;
+	std::memcpy(&value, position, sizeof(T));
+	position += sizeof(T);
+	return true;
+}
+
+bool takeString(const uint8_t*& position, const uint8_t* end, std::string& value)
+{
+	uint16_t size = 0;
+	if(!take(position, end, size) || end - position < size) return false;
+	value.assign(reinterpret_cast<const char*>(position), size);
+	position += size;
+	return true;
+}
+
+}
+
+uint64_t PeerStateFile::checksum(const uint8_t* data, size_t size)
+{
+	//FNV-1a
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for(size_t i = 0; i < size; i++)
+	{
+		hash ^= data[i];
+		hash *= 0x100000001B3ull;
+	}
+	return hash;
+}
+
+bool PeerStateFile::write(const std::string& path, uint64_t generation, const std::vector<PeerEntry>& peers)
+{
+	std::vector<uint8_t> records;
+	records.reserve(peers.size() * 48);
+	for(auto& peer : peers)
+	{
+		append<uint64_t>(records, peer.id);
+		append<int32_t>(records, peer.address);
+		append<uint32_t>(records, peer.deviceType);
+		append<int32_t>(records, peer.firmwareVersion);
+		appendString(records, peer.serialNumber);
+		appendString(records, peer.interfaceId);
+	}
+
+	std::vector<uint8_t> header;
+	header.reserve(_headerSize);
+	header.insert(header.end(), { 'I', 'T', 'P', 'S' });
+	append<uint32_t>(header, _version);
+	append<uint64_t>(header, generation);
+	append<uint32_t>(header, (uint32_t)peers.size());
+	append<uint32_t>(header, 0);
+	append<uint64_t>(header, checksum(records.data(), records.size()));
+
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if(!file) return false;
+		file.write(reinterpret_cast<const char*>(header.data()), header.size());
+		file.write(reinterpret_cast<const char*>(records.data()), records.size());
+		file.flush();
+		if(!file) return false;
+	}
+	return std::rename(tempPath.c_str(), path.c_str()) == 0;
+}
+
+bool PeerStateFile::read(const std::string& path, uint64_t generation, std::vector<PeerEntry>& peers)
+{
+	peers.clear();
+	int fileDescriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if(fileDescriptor == -1) return false;
+	struct stat fileStat{};
+	if(fstat(fileDescriptor, &fileStat) == -1 || (size_t)fileStat.st_size < _headerSize)
+	{
+		close(fileDescriptor);
+		return false;
+	}
+	size_t size = fileStat.st_size;
+	void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	close(fileDescriptor);
+	if(mapping == MAP_FAILED) return false;
+
+	const uint8_t* position = static_cast<const uint8_t*>(mapping);
+	const uint8_t* end = position + size;
+	bool valid = false;
+	uint32_t version = 0;
+	uint64_t fileGeneration = 0;
+	uint32_t peerCount = 0;
+	uint32_t reserved = 0;
+	uint64_t fileChecksum = 0;
+	if(std::memcmp(position, "ITPS", 4) == 0)
+	{
+		position += 4;
+		take(position, end, version);
+		take(position, end, fileGeneration);
+		take(position, end, peerCount);
+		take(position, end, reserved);
+		take(position, end, fileChecksum);
+		valid = version == _version && fileGeneration == generation && checksum(position, end - position) == fileChecksum;
+	}
+
+	if(valid)
+	{
+		peers.reserve(peerCount);
+		for(uint32_t i = 0; i < peerCount; i++)
+		{
+			PeerEntry peer;
+			if(!take(position, end, peer.id) || !take(position, end, peer.address) || !take(position, end, peer.deviceType) || !take(position, end, peer.firmwareVersion) || !takeString(position, end, peer.serialNumber) || !takeString(position, end, peer.interfaceId))
+			{
+				valid = false;
+				break;
+			}
+			peers.push_back(std::move(peer));
+		}
+		if(position != end) valid = false;
+	}
+
+	munmap(mapping, size);
+	if(!valid) peers.clear();
+	return valid;
+}
+
+}
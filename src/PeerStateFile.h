@@ -0,0 +1,89 @@
+/* Copyright 2013-2019 Homegear GmbH
+ *
+ * Homegear is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Homegear is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Homegear.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef PEERSTATEFILE_H_
+#define PEERSTATEFILE_H_
+
+#include <cstdint>
+
+#include <string>
+#include <vector>
+
+namespace MyFamily
+{
+
+/**
+ * Binary file holding the index data of all peers (everything MyPeer::loadIndex() reads from the database). It is written by
+ * the central whenever peers were added, removed or moved to another interface and lets the next start skip the database
+ * queries for the index. The file stores the peer generation counter of the central. It is only used when the counter matches
+ * the one stored in the database, so a file not written after the last change is ignored.
+ *
+ * The file is a cache for the local machine and uses the host's byte order. Layout:
+ *   Header: magic "ITPS", uint32 version, uint64 generation, uint32 peer count, uint32 reserved, uint64 checksum of the records
+ *   Record: uint64 id, int32 address, uint32 device type, int32 firmware version, uint16 + serial number, uint16 + interface ID
+ */
+class PeerStateFile
+{
+public:
+	struct PeerEntry
+	{
+		uint64_t id = 0;
+		int32_t address = 0;
+		uint32_t deviceType = 0;
+		int32_t firmwareVersion = 0;
+		std::string serialNumber;
+		std::string interfaceId;
+	};
+
+	/**
+	 * Writes the file. The data is written to a temporary file first, which is then renamed, so readers never see a partially
+	 * written file.
+	 *
+	 * @return Returns true on success.
+	 */
+	static bool write(const std::string& path, uint64_t generation, const std::vector<PeerEntry>& peers);
+
+	/**
+	 * Memory-maps and parses the file.
+	 *
+	 * @param generation The current peer generation. The file is rejected if it was written for another generation.
+	 * @param[out] peers The peers read from the file.
+	 * @return Returns false when the file doesn't exist, is invalid or outdated.
+	 */
+	static bool read(const std::string& path, uint64_t generation, std::vector<PeerEntry>& peers);
+protected:
+	static const uint32_t _version = 1;
+	static const uint32_t _headerSize = 32;
+
+	static uint64_t checksum(const uint8_t* data, size_t size);
+};
+
+}
+
+#endif
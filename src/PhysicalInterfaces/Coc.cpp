@@ -39,6 +39,7 @@ Coc::Coc(std::shared_ptr<BaseLib::Systems::PhysicalInterfaceSettings> settings)
 {
 	_out.init(GD::bl);
 	_out.setPrefix(GD::out.getPrefix() + "COC \"" + settings->id + "\": ");
+	_txQueueEnabled = true;
 
 	_stackPrefix = "";
 	for(uint32_t i = 1; i < settings->stackPosition; i++)
@@ -51,6 +52,7 @@ Coc::~Coc()
 {
 	try
 	{
+		stopTxThread();
 		if(_socket)
 		{
 			_socket->removeEventHandler(_eventHandlerSelf);
@@ -65,16 +67,21 @@ Coc::~Coc()
 }
 
 void Coc::sendPacket(std::shared_ptr<BaseLib::Systems::Packet> packet)
+{
+	queuePacket(packet);
+}
+
+bool Coc::writePacket(std::shared_ptr<BaseLib::Systems::Packet> packet)
 {
 	try
 	{
 		std::shared_ptr<MyPacket> myPacket(std::dynamic_pointer_cast<MyPacket>(packet));
-		if(!myPacket) return;
+		if(!myPacket) return false;
 		
 		if(!_socket)
 		{
 			_out.printError("Error: Couldn't write to COC device, because the device descriptor is not valid: " + _settings->device);
-			return;
+			return false;
 		}
 		
 		std::string hexString = "is" + myPacket->hexString() + "\n";
@@ -85,11 +92,13 @@ void Coc::sendPacket(std::shared_ptr<BaseLib::Systems::Packet> packet)
 
 		_socket->writeData(data);
 		_lastPacketSent = BaseLib::HelperFunctions::getTime();
+		return true;
 	}
 	catch(const std::exception& ex)
     {
         _out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
     }
+    return false;
 }
 
 void Coc::startListening()
@@ -123,6 +132,7 @@ void Coc::startListening()
 		_socket->writeLine(listenPacket);
 		if(!_additionalCommands.empty()) _socket->writeLine(_additionalCommands);
 		std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+		startTxThread();
 		IPhysicalInterface::startListening();
 	}
     catch(const std::exception& ex)
@@ -135,6 +145,7 @@ void Coc::stopListening()
 {
 	try
 	{
+		stopTxThread();
 		if(!_socket) return;
 		_socket->removeEventHandler(_eventHandlerSelf);
 		_socket->closeDevice();
@@ -192,7 +203,7 @@ void Coc::lineReceived(const std::string& data)
 	    }
 
 	    // Not recognized
-		if(packetHex == "LOVF\n") _out.printWarning("Warning: COC with id " + _settings->id + " reached 1% limit. You need to wait, before sending is allowed again.");
+		if(packetHex.compare(0, 4, "LOVF") == 0) dutyCycleExceeded();
 		else _out.printInfo("Info: Unknown IT packet received: " + packetHex);
 		return;
 
@@ -50,12 +50,13 @@ class Coc : public IIntertechnoInterface, public BaseLib::SerialReaderWriter::IS
         
         void sendPacket(std::shared_ptr<BaseLib::Systems::Packet> packet);
     protected:
+        virtual bool writePacket(std::shared_ptr<BaseLib::Systems::Packet> packet);
+
         // {{{ Event handling
         BaseLib::PEventHandler _eventHandlerSelf;
         virtual void lineReceived(const std::string& data);
         // }}}
 
-        BaseLib::Output _out;
         std::shared_ptr<BaseLib::SerialReaderWriter> _socket;
         std::string _stackPrefix;
     private:
@@ -37,6 +37,7 @@ Cul::Cul(std::shared_ptr<BaseLib::Systems::PhysicalInterfaceSettings> settings)
 {
 	_out.init(GD::bl);
 	_out.setPrefix(GD::out.getPrefix() + "Intertechno CUL \"" + settings->id + "\": ");
+	_txQueueEnabled = true;
 
 	signal(SIGPIPE, SIG_IGN);
 }
@@ -92,6 +93,7 @@ void Cul::startListening()
             if(_settings->listenThreadPriority > -1) _bl->threadManager.start(_listenThread, true, _settings->listenThreadPriority, _settings->listenThreadPolicy, &Cul::listen, this);
             else _bl->threadManager.start(_listenThread, true, &Cul::listen, this);
         }
+		startTxThread();
 		IPhysicalInterface::startListening();
 	}
     catch(const std::exception& ex)
@@ -104,6 +106,7 @@ void Cul::stopListening()
 {
 	try
 	{
+		stopTxThread();
 		_stopCallbackThread = true;
 		_bl->threadManager.join(_listenThread);
 		_stopped = true;
@@ -237,7 +240,7 @@ void Cul::processPacket(std::string& data)
 	    }
 
 	    // Not recognized
-		if(data.compare(0, 4, "LOVF") == 0) _out.printWarning("Warning: CUL with id " + _settings->id + " reached 1% limit. You need to wait, before sending is allowed again.");
+		if(data.compare(0, 4, "LOVF") == 0) dutyCycleExceeded();
 		else _out.printInfo("Info: Unknown IT packet received: " + data);
 		return;
 
@@ -249,16 +252,21 @@ void Cul::processPacket(std::string& data)
 }
 
 void Cul::sendPacket(std::shared_ptr<BaseLib::Systems::Packet> packet)
+{
+	queuePacket(packet);
+}
+
+bool Cul::writePacket(std::shared_ptr<BaseLib::Systems::Packet> packet)
 {
 	try
 	{
 		std::shared_ptr<MyPacket> myPacket(std::dynamic_pointer_cast<MyPacket>(packet));
-		if(!myPacket) return;
+		if(!myPacket) return false;
 
 		if(_stopped || !_serial)
 		{
 			_out.printWarning("Warning: !!!Not!!! sending packet " + myPacket->hexString() + ", because device is not open.");
-			return;
+			return false;
 		}
 
 		if(!_serial->isOpen())
@@ -268,7 +276,7 @@ void Cul::sendPacket(std::shared_ptr<BaseLib::Systems::Packet> packet)
 			if(!_serial->isOpen())
 			{
 				_out.printError("Error: Could not open device.");
-				return;
+				return false;
 			}
 			if(!_settings->openWriteonly)
             {
@@ -286,13 +294,14 @@ void Cul::sendPacket(std::shared_ptr<BaseLib::Systems::Packet> packet)
 
 		_serial->writeData(data);
 		_lastPacketSent = BaseLib::HelperFunctions::getTime();
-		// Sleep as CUL cannot handle too much commands in short time
-		std::this_thread::sleep_for(std::chrono::milliseconds(500));
+		//The CUL cannot handle too many commands in a short time. The TX thread waits "txSpacing" milliseconds before the next packet.
+		return true;
 	}
 	catch(const std::exception& ex)
     {
         _out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
     }
+    return false;
 }
 
 }
@@ -58,6 +58,7 @@ protected:
 
 	void listen();
 	void processPacket(std::string& data);
+	virtual bool writePacket(std::shared_ptr<BaseLib::Systems::Packet> packet);
 };
 
 }
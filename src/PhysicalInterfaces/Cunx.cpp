@@ -33,12 +33,23 @@
 #include "../MyCulTxPacket.h"
 #include "../MyPacket.h"
 
+#include <cctype>
+
 namespace MyFamily {
 
 Cunx::Cunx(std::shared_ptr<BaseLib::Systems::PhysicalInterfaceSettings> settings) : IIntertechnoInterface(settings) {
   _out.init(GD::bl);
   _out.setPrefix(GD::out.getPrefix() + "CUNX \"" + settings->id + "\": ");
 
+  // The CUNX buffers commands received over TCP, so there is no need to wait between packets. Queued packets are written
+  // together.
+  _txQueueEnabled = true;
+  _txSpacing = GD::family->getSettingInteger("cunxTxSpacing", 0);
+  if (_txSpacing < 0) _txSpacing = 0;
+  int32_t maxTxBatchSize = GD::family->getSettingInteger("cunxTxBatchSize", 4);
+  _maxTxBatchSize = maxTxBatchSize > 0 ? maxTxBatchSize : 1;
+  _sendBuffer.reserve(64 * _maxTxBatchSize);
+
   stackPrefix = "";
   for (uint32_t i = 1; i < settings->stackPosition; i++) {
     stackPrefix.push_back('*');
@@ -69,6 +80,7 @@ Cunx::~Cunx() {
   try {
     _stopCallbackThread = true;
     GD::bl->threadManager.join(_listenThread);
+    stopTxThread();
   }
   catch (const std::exception &ex) {
     _out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
@@ -76,35 +88,73 @@ Cunx::~Cunx() {
 }
 
 void Cunx::sendPacket(std::shared_ptr<BaseLib::Systems::Packet> packet) {
+  queuePacket(packet);
+}
+
+bool Cunx::writePacket(std::shared_ptr<BaseLib::Systems::Packet> packet) {
   try {
-    std::shared_ptr<MyPacket> myPacket(std::dynamic_pointer_cast<MyPacket>(packet));
-    if (!myPacket) return;
+    std::lock_guard<std::mutex> sendGuard(_sendMutex);
+    _sendBuffer.clear();
+    appendToSendBuffer(packet);
+    return writePacketsFromSendBuffer();
+  }
+  catch (const std::exception &ex) {
+    _out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+  }
+  return false;
+}
 
-    if (!isOpen()) {
-      _out.printWarning(std::string("Warning: !!!Not!!! sending packet, because device is not connected or opened: ") + myPacket->hexString());
-      return;
+bool Cunx::writePackets(const std::vector<std::shared_ptr<BaseLib::Systems::Packet>> &packets) {
+  try {
+    std::lock_guard<std::mutex> sendGuard(_sendMutex);
+    _sendBuffer.clear();
+    for (auto &packet : packets) {
+      appendToSendBuffer(packet);
     }
-
-    _out.printInfo("Info: Sending (" + _settings->id + "): " + myPacket->hexString());
-    send(stackPrefix + "is" + myPacket->hexString() + "\n");
-
-    _lastPacketSent = BaseLib::HelperFunctions::getTime();
+    return writePacketsFromSendBuffer();
   }
   catch (const std::exception &ex) {
     _out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
   }
+  return false;
+}
+
+void Cunx::appendToSendBuffer(const std::shared_ptr<BaseLib::Systems::Packet> &packet) {
+  std::shared_ptr<MyPacket> myPacket(std::dynamic_pointer_cast<MyPacket>(packet));
+  if (!myPacket) return;
+  _sendBuffer.append(stackPrefix).append("is");
+  myPacket->appendHexString(_sendBuffer);
+  _sendBuffer.push_back('\n');
+}
+
+bool Cunx::writePacketsFromSendBuffer() {
+  if (_sendBuffer.empty()) return false;
+  if (_bl->debugLevel >= 4) {
+    std::string message = "Info: Sending (" + _settings->id + "): ";
+    _out.printInfo(message.append(_sendBuffer, 0, getTrimmedSendBufferSize()));
+  }
+  if (!writeSendBuffer()) return false;
+
+  _lastPacketSent = BaseLib::HelperFunctions::getTime();
+  return true;
+}
+
+size_t Cunx::getTrimmedSendBufferSize() {
+  size_t size = _sendBuffer.size();
+  while (size > 0 && std::isspace((unsigned char)_sendBuffer[size - 1])) size--;
+  return size;
 }
 
-void Cunx::send(std::string data) {
+bool Cunx::writeSendBuffer() {
   try {
-    if (data.size() < 3) return; //Otherwise error in printWarning
-    std::lock_guard<std::mutex> sendGuard(_sendMutex);
     if (!_socket->Connected() || _stopped) {
-      _out.printWarning(std::string("Warning: !!!Not!!! sending: ") + data.substr(2, data.size() - 3));
-      return;
+      std::string message = "Warning: !!!Not!!! sending, because device is not connected: ";
+      _out.printWarning(message.append(_sendBuffer, 0, getTrimmedSendBufferSize()));
+      return false;
     }
-    _socket->Send((uint8_t *)data.data(), data.size());
-    return;
+    _socket->Send((uint8_t *)_sendBuffer.data(), _sendBuffer.size());
+    countWrite(_sendBuffer.size());
+    return true;
   }
   catch (const C1Net::Exception &ex) {
     _out.printError(ex.what());
@@ -113,6 +163,7 @@ void Cunx::send(std::string data) {
     _out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
   }
   _stopped = true;
+  return false;
 }
 
 void Cunx::startListening() {
@@ -135,6 +186,7 @@ void Cunx::startListening() {
     _stopped = false;
     if (_settings->listenThreadPriority > -1) GD::bl->threadManager.start(_listenThread, true, _settings->listenThreadPriority, _settings->listenThreadPolicy, &Cunx::listen, this);
     else GD::bl->threadManager.start(_listenThread, true, &Cunx::listen, this);
+    startTxThread();
     IPhysicalInterface::startListening();
   }
   catch (const std::exception &ex) {
@@ -150,8 +202,12 @@ void Cunx::reconnect() {
     _hostname = _settings->host;
     _ipAddress = _socket->GetIpAddress();
     _stopped = false;
-    send(stackPrefix + "X21\r\n");
-    if (!_additionalCommands.empty()) send(_additionalCommands); // _additionalCommands already contain stackPrefix
+    {
+      std::lock_guard<std::mutex> sendGuard(_sendMutex);
+      _sendBuffer.clear();
+      _sendBuffer.append(stackPrefix).append("X21\r\n").append(_additionalCommands); // _additionalCommands already contain stackPrefix
+      writeSendBuffer();
+    }
     _out.printInfo("Connected to CUNX device with hostname " + _settings->host + " on port " + _settings->port + ".");
   }
   catch (const std::exception &ex) {
@@ -161,6 +217,7 @@ void Cunx::reconnect() {
 
 void Cunx::stopListening() {
   try {
+    stopTxThread();
     _stopCallbackThread = true;
     GD::bl->threadManager.join(_listenThread);
     _stopCallbackThread = false;
@@ -270,7 +327,7 @@ void Cunx::processData(std::vector<uint8_t> &data) {
       }
 
       // Not recognized
-      if (packetHex == "LOVF\n") _out.printWarning("Warning: CUNX with id " + _settings->id + " reached 1% limit. You need to wait, before sending is allowed again.");
+      if (packetHex.compare(0, 4, "LOVF") == 0) dutyCycleExceeded();
       else _out.printInfo("Info: Unknown IT packet received: " + packetHex);
       continue;
 
@@ -49,14 +49,40 @@ class Cunx : public IIntertechnoInterface
 		
 		void sendPacket(std::shared_ptr<BaseLib::Systems::Packet> packet);
     protected:
-        BaseLib::Output _out;
         std::string _port;
         std::unique_ptr<C1Net::TcpSocket> _socket;
         std::string stackPrefix;
 
+        /**
+         * Packets and initialisation commands are collected here and written to the socket with one call. Only used with
+         * _sendMutex locked. The buffer is reused, so it doesn't need to be allocated for every write.
+         */
+        std::string _sendBuffer;
+
         void reconnect();
         void processData(std::vector<uint8_t>& data);
-        void send(std::string data);
+        bool writePacket(std::shared_ptr<BaseLib::Systems::Packet> packet);
+        bool writePackets(const std::vector<std::shared_ptr<BaseLib::Systems::Packet>>& packets);
+
+        /**
+         * Appends the command sending the packet to _sendBuffer. Needs to be called with _sendMutex locked.
+         */
+        void appendToSendBuffer(const std::shared_ptr<BaseLib::Systems::Packet>& packet);
+
+        /**
+         * Writes the packets collected in _sendBuffer and logs them. Needs to be called with _sendMutex locked.
+         */
+        bool writePacketsFromSendBuffer();
+
+        /**
+         * Returns the size of _sendBuffer without trailing whitespace, so the buffer can be logged without copying and trimming it.
+         */
+        size_t getTrimmedSendBufferSize();
+
+        /**
+         * Writes _sendBuffer to the socket. Needs to be called with _sendMutex locked.
+         */
+        bool writeSendBuffer();
         std::string readFromDevice();
         void listen();
     private:
@@ -32,6 +32,8 @@
 #include "IIntertechnoInterface.h"
 #include "../MyCulTxPacket.h"
 
+#include <algorithm>
+
 namespace MyFamily
 {
 
@@ -45,6 +47,21 @@ IIntertechnoInterface::IIntertechnoInterface(std::shared_ptr<BaseLib::Systems::P
 		settings->listenThreadPolicy = SCHED_OTHER;
 	}
 
+	_txSpacing = GD::family->getSettingInteger("txSpacing", 500);
+	if(_txSpacing < 0) _txSpacing = 0;
+	int32_t maxTxQueueSize = GD::family->getSettingInteger("txQueueSize", 100);
+	_maxTxQueueSize = maxTxQueueSize > 0 ? maxTxQueueSize : 1;
+
+	int32_t dutyCycleLimit = GD::family->getSettingInteger("dutyCycleLimit", 100); //In percent, 100 disables the limit
+	if(dutyCycleLimit < 1 || dutyCycleLimit > 100) dutyCycleLimit = 100;
+	_dutyCycleBudget = DutyCycleBudget(dutyCycleLimit * 36000);
+	int32_t dutyCycleReserve = GD::family->getSettingInteger("dutyCycleReserve", 10); //In percent of the budget
+	if(dutyCycleReserve < 0 || dutyCycleReserve > 100) dutyCycleReserve = 0;
+	_dutyCycleReserve = _dutyCycleBudget.getBudget() * dutyCycleReserve / 100;
+	_txRepetitions = GD::family->getSettingInteger("txRepetitions", 6);
+	if(_txRepetitions < 1) _txRepetitions = 1;
+	_dutyCycleReroute = GD::family->getSettingInteger("dutyCycleReroute", 1) != 0;
+
 	std::vector<std::string> additionalCommands = BaseLib::HelperFunctions::splitAll(settings->additionalCommands, ',');
 	for(std::string& command : additionalCommands)
 	{
@@ -55,8 +72,373 @@ IIntertechnoInterface::IIntertechnoInterface(std::shared_ptr<BaseLib::Systems::P
 
 IIntertechnoInterface::~IIntertechnoInterface()
 {
+	stopTxThread();
+}
+
+std::shared_future<bool> IIntertechnoInterface::queuePacket(std::shared_ptr<BaseLib::Systems::Packet> packet, TxPriority priority, uint64_t coalescingKey)
+{
+	TxQueueEntry entry;
+	entry.packet = packet;
+	entry.sent = std::make_shared<std::promise<bool>>();
+	entry.priority = priority;
+	entry.coalescingKey = coalescingKey;
+	std::shared_future<bool> sent = entry.sent->get_future().share();
+	try
+	{
+		entry.airtime = getAirtime(packet);
+		if(!_txQueueEnabled)
+		{
+			sendPacket(packet);
+			{
+				std::lock_guard<std::mutex> txQueueGuard(_txQueueMutex);
+				_dutyCycleBudget.add(entry.airtime, BaseLib::HelperFunctions::getTime());
+			}
+			entry.sent->set_value(true);
+			return sent;
+		}
 
+		enqueue(std::move(entry));
+	}
+	catch(const std::exception& ex)
+	{
+		_out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+	return sent;
 }
 
+void IIntertechnoInterface::enqueue(TxQueueEntry&& entry)
+{
+	{
+		std::lock_guard<std::mutex> txQueueGuard(_txQueueMutex);
+		if(_stopTxThread)
+		{
+			//The device couldn't be opened or isn't listening. The packet would never be sent.
+			_txStatistics.failed++;
+			setSent(entry, false);
+			std::shared_ptr<MyPacket> myPacket = std::dynamic_pointer_cast<MyPacket>(entry.packet);
+			_out.printWarning("Warning: !!!Not!!! sending packet " + (myPacket ? myPacket->hexString() : std::string()) + ", because device is not open.");
+			return;
+		}
+
+		if(entry.coalescingKey != 0)
+		{
+			for(auto& queuedEntry : _txQueue)
+			{
+				if(queuedEntry.coalescingKey != entry.coalescingKey) continue;
+				queuedEntry.replaced.push_back(std::move(queuedEntry.sent));
+				queuedEntry.replaced.insert(queuedEntry.replaced.end(), entry.replaced.begin(), entry.replaced.end());
+				queuedEntry.sent = std::move(entry.sent);
+				queuedEntry.packet = std::move(entry.packet);
+				queuedEntry.airtime = entry.airtime;
+				_txStatistics.coalesced++;
+				return;
+			}
+		}
+
+		if(_txQueue.size() >= _maxTxQueueSize)
+		{
+			_txStatistics.dropped++;
+			setSent(entry, false);
+			_out.printWarning("Warning: TX queue is full. Dropping packet.");
+			return;
+		}
+		insertByPriority(std::move(entry), false);
+	}
+	_txQueueConditionVariable.notify_one();
+}
+
+void IIntertechnoInterface::insertByPriority(TxQueueEntry&& entry, bool front)
+{
+	//High priority packets are queued before all normal priority packets.
+	auto position = _txQueue.end();
+	if(entry.priority == TxPriority::high)
+	{
+		position = front ? _txQueue.begin() : std::find_if(_txQueue.begin(), _txQueue.end(), [](const TxQueueEntry& queuedEntry) { return queuedEntry.priority != TxPriority::high; });
+	}
+	else if(front)
+	{
+		position = std::find_if(_txQueue.begin(), _txQueue.end(), [](const TxQueueEntry& queuedEntry) { return queuedEntry.priority != TxPriority::high; });
+	}
+	_txQueue.insert(position, std::move(entry));
+	if(_txQueue.size() > _txStatistics.maxQueueSize) _txStatistics.maxQueueSize = _txQueue.size();
+}
+
+void IIntertechnoInterface::setSent(TxQueueEntry& entry, bool sent)
+{
+	entry.sent->set_value(sent);
+	for(auto& replaced : entry.replaced)
+	{
+		replaced->set_value(sent);
+	}
+}
+
+IIntertechnoInterface::TxStatistics IIntertechnoInterface::getTxStatistics()
+{
+	std::lock_guard<std::mutex> txQueueGuard(_txQueueMutex);
+	TxStatistics statistics = _txStatistics;
+	statistics.queued = _txQueueEnabled;
+	statistics.spacing = _txSpacing;
+	statistics.queueSize = _txQueue.size();
+	statistics.airtimeBudget = _dutyCycleBudget.getBudget();
+	statistics.airtimeUsed = _dutyCycleBudget.getUsed(BaseLib::HelperFunctions::getTime());
+	return statistics;
+}
+
+int64_t IIntertechnoInterface::getRemainingAirtime()
+{
+	std::lock_guard<std::mutex> txQueueGuard(_txQueueMutex);
+	int64_t remaining = _dutyCycleBudget.getBudget() - _dutyCycleBudget.getUsed(BaseLib::HelperFunctions::getTime());
+	return remaining > 0 ? remaining : 0;
+}
+
+bool IIntertechnoInterface::writePackets(const std::vector<std::shared_ptr<BaseLib::Systems::Packet>>& packets)
+{
+	bool sent = true;
+	for(auto& packet : packets)
+	{
+		if(!writePacket(packet)) sent = false;
+	}
+	return sent;
+}
+
+void IIntertechnoInterface::countWrite(size_t bytes)
+{
+	std::lock_guard<std::mutex> txQueueGuard(_txQueueMutex);
+	_txStatistics.writes++;
+	_txStatistics.bytesWritten += bytes;
+}
+
+void IIntertechnoInterface::startTxThread()
+{
+	try
+	{
+		stopTxThread();
+		_stopTxThread = false;
+		_bl->threadManager.start(_txThread, true, &IIntertechnoInterface::txThread, this);
+	}
+	catch(const std::exception& ex)
+	{
+		_out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+}
+
+void IIntertechnoInterface::stopTxThread()
+{
+	try
+	{
+		std::deque<TxQueueEntry> txQueue;
+		{
+			std::lock_guard<std::mutex> txQueueGuard(_txQueueMutex);
+			_stopTxThread = true;
+			txQueue.swap(_txQueue);
+			_txStatistics.dropped += txQueue.size();
+		}
+		_txQueueConditionVariable.notify_all();
+		_bl->threadManager.join(_txThread);
+		for(auto& entry : txQueue)
+		{
+			setSent(entry, false);
+		}
+	}
+	catch(const std::exception& ex)
+	{
+		_out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+}
+
+void IIntertechnoInterface::txThread()
+{
+	std::chrono::steady_clock::time_point nextSend = std::chrono::steady_clock::now();
+	while(true)
+	{
+		try
+		{
+			TxQueueEntry entry;
+			std::vector<TxQueueEntry> batch; //Further packets written together with entry
+			bool reroute = false;
+			{
+				std::unique_lock<std::mutex> txQueueGuard(_txQueueMutex);
+				_txQueueConditionVariable.wait(txQueueGuard, [&] { return _stopTxThread || !_txQueue.empty(); });
+				if(_stopTxThread) return;
+				//Keep the packet queued while waiting, so it is included in the queue size.
+				if(_txQueueConditionVariable.wait_until(txQueueGuard, nextSend, [&] { return _stopTxThread; })) return;
+				if(_txQueue.empty()) continue;
+
+				int64_t time = BaseLib::HelperFunctions::getTime();
+				TxQueueEntry& front = _txQueue.front();
+				int64_t availableTime = getAvailableTime(front, time);
+				if(availableTime > time)
+				{
+					if(_dutyCycleReroute && !front.rerouted)
+					{
+						front.rerouted = true;
+						entry = std::move(front);
+						_txQueue.pop_front();
+						reroute = true;
+					}
+					else
+					{
+						if(!front.deferred)
+						{
+							front.deferred = true;
+							_txStatistics.deferred++;
+							_out.printInfo("Info: Duty cycle budget is used up. Deferring packet for " + std::to_string((availableTime - time) / 1000) + " seconds.");
+						}
+						//Wakes up when new packets are queued, so high priority packets can use the reserve in the meantime.
+						_txQueueConditionVariable.wait_for(txQueueGuard, std::chrono::milliseconds(std::min(availableTime - time, (int64_t)60000)));
+						continue;
+					}
+				}
+				else
+				{
+					entry = std::move(front);
+					_txQueue.pop_front();
+
+					int64_t pendingAirtime = entry.airtime;
+					while(batch.size() + 1 < _maxTxBatchSize && !_txQueue.empty() && getAvailableTime(_txQueue.front(), time, pendingAirtime) <= time)
+					{
+						pendingAirtime += _txQueue.front().airtime;
+						batch.push_back(std::move(_txQueue.front()));
+						_txQueue.pop_front();
+					}
+				}
+			}
+
+			if(reroute)
+			{
+				std::shared_ptr<IIntertechnoInterface> target = findRerouteTarget(entry);
+				if(target)
+				{
+					_out.printInfo("Info: Duty cycle budget is used up. Sending packet via interface " + target->getID() + ".");
+					{
+						std::lock_guard<std::mutex> txQueueGuard(_txQueueMutex);
+						_txStatistics.rerouted++;
+					}
+					target->enqueue(std::move(entry));
+				}
+				else
+				{
+					//Put it back in front of the packets of the same priority. High priority packets queued in the meantime
+					//still go first. It is deferred when it is at the front again.
+					std::lock_guard<std::mutex> txQueueGuard(_txQueueMutex);
+					insertByPriority(std::move(entry), true);
+				}
+				continue;
+			}
+
+			bool sent = false;
+			if(batch.empty()) sent = writePacket(entry.packet);
+			else
+			{
+				std::vector<std::shared_ptr<BaseLib::Systems::Packet>> packets;
+				packets.reserve(batch.size() + 1);
+				packets.push_back(entry.packet);
+				for(auto& batchEntry : batch)
+				{
+					packets.push_back(batchEntry.packet);
+				}
+				sent = writePackets(packets);
+			}
+			nextSend = std::chrono::steady_clock::now() + std::chrono::milliseconds(_txSpacing);
+			batch.insert(batch.begin(), std::move(entry));
+			{
+				std::lock_guard<std::mutex> txQueueGuard(_txQueueMutex);
+				int64_t time = BaseLib::HelperFunctions::getTime();
+				for(auto& batchEntry : batch)
+				{
+					if(sent)
+					{
+						_txStatistics.sent++;
+						_dutyCycleBudget.add(batchEntry.airtime, time);
+					}
+					else _txStatistics.failed++;
+				}
+			}
+			for(auto& batchEntry : batch)
+			{
+				setSent(batchEntry, sent);
+			}
+		}
+		catch(const std::exception& ex)
+		{
+			_out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+		}
+	}
+}
+
+int64_t IIntertechnoInterface::getAirtime(const std::shared_ptr<BaseLib::Systems::Packet>& packet)
+{
+	std::shared_ptr<MyPacket> myPacket = std::dynamic_pointer_cast<MyPacket>(packet);
+	if(!myPacket) return 0;
+	return ((int64_t)myPacket->getAirtime() * _txRepetitions + 999) / 1000;
+}
+
+int64_t IIntertechnoInterface::getAvailableTime(const TxQueueEntry& entry, int64_t time, int64_t pendingAirtime)
+{
+	int64_t limit = _dutyCycleBudget.getBudget();
+	if(entry.priority == TxPriority::normal) limit -= _dutyCycleReserve;
+	return _dutyCycleBudget.getAvailableTime(entry.airtime + pendingAirtime, limit, time);
+}
+
+bool IIntertechnoInterface::canSendNow(const TxQueueEntry& entry)
+{
+	std::lock_guard<std::mutex> txQueueGuard(_txQueueMutex);
+	if(_stopTxThread) return false;
+	int64_t time = BaseLib::HelperFunctions::getTime();
+	return getAvailableTime(entry, time) <= time;
+}
+
+uint32_t IIntertechnoInterface::getTxQueueSize()
+{
+	std::lock_guard<std::mutex> txQueueGuard(_txQueueMutex);
+	return _txQueue.size();
+}
+
+bool IIntertechnoInterface::isQueued(uint64_t coalescingKey)
+{
+	std::lock_guard<std::mutex> txQueueGuard(_txQueueMutex);
+	return std::any_of(_txQueue.begin(), _txQueue.end(), [&](const TxQueueEntry& queuedEntry) { return queuedEntry.coalescingKey == coalescingKey; });
+}
+
+bool IIntertechnoInterface::canSend(const std::shared_ptr<BaseLib::Systems::Packet>& packet, TxPriority priority)
+{
+	try
+	{
+		if(!isOpen()) return false;
+		TxQueueEntry entry;
+		entry.priority = priority;
+		entry.airtime = getAirtime(packet);
+		std::lock_guard<std::mutex> txQueueGuard(_txQueueMutex);
+		if(_txQueueEnabled && _stopTxThread) return false;
+		int64_t time = BaseLib::HelperFunctions::getTime();
+		return getAvailableTime(entry, time) <= time;
+	}
+	catch(const std::exception& ex)
+	{
+		_out.printEx(__FILE__, __LINE__, __PRETTY_FUNCTION__, ex.what());
+	}
+	return false;
+}
+
+std::shared_ptr<IIntertechnoInterface> IIntertechnoInterface::findRerouteTarget(const TxQueueEntry& entry)
+{
+	for(auto& interface : GD::physicalInterfaces)
+	{
+		if(interface.second.get() == this || !interface.second->_txQueueEnabled || !interface.second->isOpen()) continue;
+		if(interface.second->canSendNow(entry)) return interface.second;
+	}
+	return std::shared_ptr<IIntertechnoInterface>();
+}
+
+void IIntertechnoInterface::dutyCycleExceeded()
+{
+	_out.printWarning("Warning: Device reached the duty cycle limit. Packets are deferred until budget is available again.");
+	{
+		std::lock_guard<std::mutex> txQueueGuard(_txQueueMutex);
+		_txStatistics.dutyCycleExceeded++;
+		_dutyCycleBudget.exhaust(BaseLib::HelperFunctions::getTime());
+	}
+	_txQueueConditionVariable.notify_one();
+}
 
 }
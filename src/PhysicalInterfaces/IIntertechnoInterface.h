@@ -30,14 +30,47 @@
 #ifndef IINTERTECHNOINTERFACE_H_
 #define IINTERTECHNOINTERFACE_H_
 
+#include "../DutyCycleBudget.h"
 #include <homegear-base/BaseLib.h>
 
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 namespace MyFamily
 {
 
 class IIntertechnoInterface : public BaseLib::Systems::IPhysicalInterface
 {
 public:
+	enum class TxPriority : int32_t
+	{
+		normal = 0,
+		high = 1 //Sent before normal packets and may use the duty cycle reserve
+	};
+
+	struct TxStatistics
+	{
+		bool queued = false; //False when packets are sent on the caller's thread
+		int32_t spacing = 0; //In milliseconds
+		uint32_t queueSize = 0;
+		uint32_t maxQueueSize = 0;
+		uint64_t sent = 0;
+		uint64_t failed = 0;
+		uint64_t dropped = 0;
+		uint64_t coalesced = 0; //Packets replaced by a newer packet with the same coalescing key before being sent
+		uint64_t deferred = 0; //Packets which had to wait for duty cycle budget
+		uint64_t rerouted = 0; //Packets handed to another interface because of the duty cycle
+		uint64_t dutyCycleExceeded = 0; //Number of LOVF messages received from the device
+		int64_t airtimeBudget = 0; //In milliseconds per hour
+		int64_t airtimeUsed = 0; //In milliseconds during the last hour
+		uint64_t writes = 0; //Write calls to the device. Only counted by interfaces calling countWrite().
+		uint64_t bytesWritten = 0;
+	};
+
 	IIntertechnoInterface(std::shared_ptr<BaseLib::Systems::PhysicalInterfaceSettings> settings);
 	virtual ~IIntertechnoInterface();
 
@@ -45,10 +78,145 @@ public:
 	virtual void stopListening() {}
 
 	virtual void sendPacket(std::shared_ptr<BaseLib::Systems::Packet> packet) {}
+
+	/**
+	 * Sends a packet. On interfaces with TX queue the packet is queued and the method returns immediately. Otherwise the packet
+	 * is sent by calling sendPacket().
+	 *
+	 * @param coalescingKey When not 0, a queued packet with the same key which wasn't sent yet is replaced by this packet (last
+	 * writer wins). The replaced packet keeps its position in the queue.
+	 * @return Returns a future which is set to true after the packet was written to the device or to false when it couldn't be
+	 * sent or was dropped. The future of a replaced packet gets the result of the packet replacing it.
+	 */
+	std::shared_future<bool> queuePacket(std::shared_ptr<BaseLib::Systems::Packet> packet, TxPriority priority = TxPriority::normal, uint64_t coalescingKey = 0);
+
+	TxStatistics getTxStatistics();
+
+	/**
+	 * Returns the duty cycle airtime left for the current hour in milliseconds.
+	 */
+	int64_t getRemainingAirtime();
+
+	/**
+	 * Returns the number of packets waiting in the TX queue. Always 0 on interfaces without TX queue.
+	 */
+	uint32_t getTxQueueSize();
+
+	/**
+	 * Returns true when a packet with the coalescing key is waiting in the TX queue.
+	 */
+	bool isQueued(uint64_t coalescingKey);
+
+	/**
+	 * Returns true when the interface is open and has enough duty cycle budget left to send the packet right away.
+	 */
+	bool canSend(const std::shared_ptr<BaseLib::Systems::Packet>& packet, TxPriority priority);
 protected:
 	BaseLib::SharedObjects* _bl = nullptr;
 	BaseLib::Output _out;
 	std::string _additionalCommands;
+
+	//{{{ TX queue
+	/**
+	 * Interfaces which need a pause between two packets set _txQueueEnabled in their constructor, implement writePacket() and
+	 * call startTxThread() and stopTxThread() when starting and stopping to listen. _txThread then writes the queued packets
+	 * with at least _txSpacing milliseconds in between, so callers don't wait for the device. Interfaces setting _maxTxBatchSize
+	 * to more than 1 get up to that many queued packets at once in writePackets(), so they can be written with one call.
+	 */
+	struct TxQueueEntry
+	{
+		std::shared_ptr<BaseLib::Systems::Packet> packet;
+		std::shared_ptr<std::promise<bool>> sent;
+		std::vector<std::shared_ptr<std::promise<bool>>> replaced; //Promises of the packets replaced by this one
+		TxPriority priority = TxPriority::normal;
+		uint64_t coalescingKey = 0;
+		int64_t airtime = 0; //In milliseconds including all repetitions
+		bool deferred = false;
+		bool rerouted = false; //Rerouting was tried already
+	};
+
+	bool _txQueueEnabled = false;
+	int32_t _txSpacing = 0;
+	uint32_t _maxTxQueueSize = 100;
+	uint32_t _maxTxBatchSize = 1;
+	std::thread _txThread;
+	std::mutex _txQueueMutex;
+	std::condition_variable _txQueueConditionVariable;
+	std::deque<TxQueueEntry> _txQueue;
+	bool _stopTxThread = true;
+	TxStatistics _txStatistics;
+
+	void enqueue(TxQueueEntry&& entry);
+
+	/**
+	 * Inserts the entry into _txQueue behind all packets of higher priority, without coalescing. When front is true, the entry
+	 * is inserted before the other packets of its priority, otherwise behind them. _txQueueMutex needs to be locked.
+	 */
+	void insertByPriority(TxQueueEntry&& entry, bool front);
+
+	/**
+	 * Sets the promise of the entry and of all entries replaced by it.
+	 */
+	static void setSent(TxQueueEntry& entry, bool sent);
+
+	/**
+	 * Writes a packet to the device. Called by _txThread.
+	 *
+	 * @return Returns true when the packet was written.
+	 */
+	virtual bool writePacket(std::shared_ptr<BaseLib::Systems::Packet> packet) { return false; }
+
+	/**
+	 * Writes several packets to the device. Called by _txThread when more than one packet can be sent. The default
+	 * implementation calls writePacket() for each packet.
+	 *
+	 * @return Returns true when all packets were written.
+	 */
+	virtual bool writePackets(const std::vector<std::shared_ptr<BaseLib::Systems::Packet>>& packets);
+
+	/**
+	 * Adds a write call with the given number of bytes to the TX statistics.
+	 */
+	void countWrite(size_t bytes);
+
+	void startTxThread();
+
+	/**
+	 * Stops _txThread. Packets still queued are dropped.
+	 */
+	void stopTxThread();
+	void txThread();
+	//}}}
+
+	//{{{ Duty cycle
+	/**
+	 * The airtime of every packet sent (estimated from the frame length and _txRepetitions) is added to _dutyCycleBudget. The
+	 * TX thread defers packets which would exceed the budget. Normal priority packets additionally leave _dutyCycleReserve
+	 * milliseconds for high priority packets. When _dutyCycleReroute is set, a deferred packet is handed to another interface
+	 * which still has enough budget. dutyCycleExceeded() is called when the device reports "LOVF". The budget is then treated
+	 * as used up.
+	 */
+	DutyCycleBudget _dutyCycleBudget;
+	int64_t _dutyCycleReserve = 0;
+	int32_t _txRepetitions = 6;
+	bool _dutyCycleReroute = true;
+
+	int64_t getAirtime(const std::shared_ptr<BaseLib::Systems::Packet>& packet);
+
+	/**
+	 * Returns the time (in milliseconds since epoch) when the entry can be sent. Called with _txQueueMutex locked.
+	 *
+	 * @param pendingAirtime Airtime of packets about to be sent, but not added to the budget yet.
+	 */
+	int64_t getAvailableTime(const TxQueueEntry& entry, int64_t time, int64_t pendingAirtime = 0);
+
+	/**
+	 * Returns an interface with TX queue able to send a packet immediately or nullptr.
+	 */
+	std::shared_ptr<IIntertechnoInterface> findRerouteTarget(const TxQueueEntry& entry);
+	bool canSendNow(const TxQueueEntry& entry);
+	void dutyCycleExceeded();
+	//}}}
 };
 
 }
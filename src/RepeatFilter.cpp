@@ -0,0 +1,82 @@
+/* Copyright 2013-2019 Homegear GmbH
+ *
+ * Homegear is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Homegear is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Homegear.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "RepeatFilter.h"
+
+#include <chrono>
+
+namespace MyFamily
+{
+
+RepeatFilter::RepeatFilter(int64_t window)
+{
+	_statistics.window = window;
+}
+
+int64_t RepeatFilter::getTimeMilliseconds()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool RepeatFilter::isRepeat(uint64_t frameKey)
+{
+	int64_t now = getTimeMilliseconds();
+	uint64_t hash = frameKey * 0x9E3779B97F4A7C15ull;
+	uint32_t index = (uint32_t)(hash >> 32) & (_tableSize - 1);
+
+	std::lock_guard<std::mutex> tableGuard(_tableMutex);
+	//Entries are only ever replaced, never removed. So a frame is always found within the probe range it was inserted in.
+	Slot* freeSlot = nullptr;
+	for(uint32_t i = 0; i < _maxProbes; i++)
+	{
+		Slot& slot = _table[(index + i) & (_tableSize - 1)];
+		if(slot.time != 0 && slot.frameKey == frameKey)
+		{
+			bool repeat = now - slot.time < _statistics.window;
+			slot.time = now;
+			if(repeat) _statistics.suppressed++;
+			else _statistics.passed++;
+			return repeat;
+		}
+		if(!freeSlot || slot.time < freeSlot->time) freeSlot = &slot; //Empty or oldest slot
+	}
+
+	freeSlot->frameKey = frameKey;
+	freeSlot->time = now;
+	_statistics.passed++;
+	return false;
+}
+
+RepeatFilter::Statistics RepeatFilter::getStatistics()
+{
+	std::lock_guard<std::mutex> tableGuard(_tableMutex);
+	return _statistics;
+}
+
+}
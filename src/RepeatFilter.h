@@ -0,0 +1,88 @@
+/* Copyright 2013-2019 Homegear GmbH
+ *
+ * Homegear is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Homegear is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Homegear.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef REPEATFILTER_H_
+#define REPEATFILTER_H_
+
+#include <cstdint>
+
+#include <array>
+#include <mutex>
+
+namespace MyFamily
+{
+
+/**
+ * Detects repeated frames. Intertechno and Elro remotes send every command several times. The filter remembers the frames seen
+ * recently in a small open-addressed hash table and reports a frame as repeat when the same frame was seen less than "window"
+ * milliseconds ago. Every repeat restarts the window, so a whole burst is suppressed as long as the gaps between the frames are
+ * shorter than the window.
+ */
+class RepeatFilter
+{
+public:
+	struct Statistics
+	{
+		int64_t window = 0; //In milliseconds
+		uint64_t passed = 0;
+		uint64_t suppressed = 0;
+	};
+
+	RepeatFilter(int64_t window);
+	virtual ~RepeatFilter() = default;
+
+	/**
+	 * Checks if a frame is a repeat and remembers it.
+	 *
+	 * @param frameKey A value uniquely identifying the frame content (see MyPacket::getFrameKey() and MyCulTxPacket::getFrameKey()).
+	 * @return Returns true when the frame is a repeat and should be dropped.
+	 */
+	bool isRepeat(uint64_t frameKey);
+
+	Statistics getStatistics();
+protected:
+	static const uint32_t _tableSize = 64; //Needs to be a power of two
+	static const uint32_t _maxProbes = 8;
+
+	struct Slot
+	{
+		uint64_t frameKey = 0;
+		int64_t time = 0;
+	};
+
+	std::mutex _tableMutex;
+	std::array<Slot, _tableSize> _table;
+	Statistics _statistics;
+
+	static int64_t getTimeMilliseconds();
+};
+
+}
+
+#endif
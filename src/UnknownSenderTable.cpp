@@ -0,0 +1,84 @@
+/* Copyright 2013-2019 Homegear GmbH
+ *
+ * Homegear is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Homegear is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Homegear.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "UnknownSenderTable.h"
+
+#include <algorithm>
+
+namespace MyFamily
+{
+
+bool UnknownSenderTable::record(SenderType type, int32_t senderAddress, const std::array<Candidate, 3>& candidates, uint8_t rssi, int64_t time)
+{
+	std::lock_guard<std::mutex> tableGuard(_tableMutex);
+	Entry* oldestEntry = nullptr;
+	for(auto& entry : _table)
+	{
+		if(entry.count > 0 && entry.type == type && entry.senderAddress == senderAddress)
+		{
+			entry.count++;
+			entry.lastSeen = time;
+			if(rssi < entry.bestRssi) entry.bestRssi = rssi;
+			return false;
+		}
+		if(!oldestEntry || entry.lastSeen < oldestEntry->lastSeen) oldestEntry = &entry; //Unused entries have lastSeen 0
+	}
+
+	oldestEntry->type = type;
+	oldestEntry->senderAddress = senderAddress;
+	oldestEntry->candidates = candidates;
+	oldestEntry->count = 1;
+	oldestEntry->firstSeen = time;
+	oldestEntry->lastSeen = time;
+	oldestEntry->bestRssi = rssi;
+	return true;
+}
+
+std::vector<UnknownSenderTable::Entry> UnknownSenderTable::getEntries()
+{
+	std::vector<Entry> entries;
+	{
+		std::lock_guard<std::mutex> tableGuard(_tableMutex);
+		entries.reserve(_tableSize);
+		for(auto& entry : _table)
+		{
+			if(entry.count > 0) entries.push_back(entry);
+		}
+	}
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.count > b.count || (a.count == b.count && a.lastSeen > b.lastSeen); });
+	return entries;
+}
+
+void UnknownSenderTable::clear()
+{
+	std::lock_guard<std::mutex> tableGuard(_tableMutex);
+	_table.fill(Entry());
+}
+
+}
@@ -0,0 +1,99 @@
+/* Copyright 2013-2019 Homegear GmbH
+ *
+ * Homegear is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Homegear is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Homegear.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef UNKNOWNSENDERTABLE_H_
+#define UNKNOWNSENDERTABLE_H_
+
+#include <cstdint>
+
+#include <array>
+#include <mutex>
+#include <vector>
+
+namespace MyFamily
+{
+
+/**
+ * Fixed-size table of frames received from senders not paired to the central. Recording a frame doesn't allocate memory or build
+ * strings, so frames of neighbours' devices and noise don't cost more than a table lookup. The table is listed by the CLI command
+ * "unknown" and the RPC method "getUnknownSenders".
+ */
+class UnknownSenderTable
+{
+public:
+	enum class SenderType : int32_t
+	{
+		tristate = 0, //Elro and old Intertechno devices
+		selfLearning = 1, //Self-learning Intertechno devices
+		cultx = 2
+	};
+
+	struct Candidate
+	{
+		int32_t deviceType = -1; //-1 when unused. For self-learning devices 0x10 is stored, but 0x10 to 0x1F are possible.
+		int32_t address = 0;
+	};
+
+	struct Entry
+	{
+		SenderType type = SenderType::tristate;
+		int32_t senderAddress = 0;
+		std::array<Candidate, 3> candidates;
+		uint64_t count = 0;
+		int64_t firstSeen = 0; //In milliseconds since epoch
+		int64_t lastSeen = 0; //In milliseconds since epoch
+		uint8_t bestRssi = 0; //As returned by getRssi(), smaller is better
+	};
+
+	UnknownSenderTable() = default;
+	virtual ~UnknownSenderTable() = default;
+
+	/**
+	 * Records a frame of an unknown sender. When the table is full, the entry seen least recently is replaced.
+	 *
+	 * @return Returns true when the sender was not in the table yet.
+	 */
+	bool record(SenderType type, int32_t senderAddress, const std::array<Candidate, 3>& candidates, uint8_t rssi, int64_t time);
+
+	/**
+	 * Returns all entries sorted by count (highest first).
+	 */
+	std::vector<Entry> getEntries();
+
+	void clear();
+protected:
+	static const uint32_t _tableSize = 64;
+
+	std::mutex _tableMutex;
+	std::array<Entry, _tableSize> _table;
+};
+
+}
+
+#endif